@@ -1,23 +1,75 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
-// Maximum vertices
-#define MAX 100
+// Build with -fopenmp to run the parallel algorithms on every core; without
+// it the same code runs sequentially
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-// Node structure for adjacency list
-typedef struct Node
+// Maximum number of threads a parallel region may use
+int threadCount(void)
 {
-    int vertex;
-    struct Node *next;
-} Node;
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// Number of threads in the current parallel region
+int activeThreads(void)
+{
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+// Index of the calling thread inside the current parallel region
+int threadId(void)
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
 
-// Edge structure for Kruskal's Algorithm
+// Edge structure for building graphs and for Kruskal's Algorithm
 typedef struct Edge
 {
     int src, dest, weight;
 } Edge;
 
+// Compressed sparse row (CSR) graph: the neighbors of vertex v are
+// targets[offsets[v]] .. targets[offsets[v + 1] - 1], with matching weights
+typedef struct Graph
+{
+    int vertices;
+    int directed;  // 0 if every edge is stored in both directions
+    long arcs;     // Number of stored (directed) arcs
+    long *offsets; // vertices + 1 entries
+    int *targets;
+    int *weights;
+    void *mapping;      // File mapping backing the arrays, or NULL if owned
+    size_t mappingSize;
+    int *originalIds;   // Caller's id of each vertex after reorderGraph, else NULL
+    int *internalIds;   // Inverse of originalIds
+} Graph;
+
 // Union-Find structure
 typedef struct Subset
 {
@@ -25,37 +77,372 @@ typedef struct Subset
     int rank;
 } Subset;
 
-// Global variables
-Node *adjList[MAX] = {NULL};
-int graph[MAX][MAX] = {0}; // Adjacency matrix for weighted graph
+// Allocate memory or abort the program
+void *allocate(size_t size)
+{
+    void *memory = malloc(size > 0 ? size : 1);
+    if (memory == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    return memory;
+}
+
+// Allocate zero-initialized memory or abort the program
+void *allocateZeroed(size_t count, size_t size)
+{
+    void *memory = calloc(count > 0 ? count : 1, size);
+    if (memory == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    return memory;
+}
+
+// Build a CSR graph from an edge list: count degrees, prefix-sum them into
+// offsets, then scatter every edge into its slot
+Graph *buildGraph(const Edge edges[], long edgeCount, int vertices, int directed)
+{
+    Graph *g = (Graph *)allocate(sizeof(Graph));
+    g->vertices = vertices;
+    g->directed = directed;
+    g->mapping = NULL;
+    g->mappingSize = 0;
+    g->originalIds = NULL;
+    g->internalIds = NULL;
+    g->offsets = (long *)allocateZeroed(vertices + 1, sizeof(long));
+
+    for (long i = 0; i < edgeCount; i++)
+    {
+        if (edges[i].src < 0 || edges[i].src >= vertices || edges[i].dest < 0 || edges[i].dest >= vertices)
+        {
+            printf("Edge (%d, %d) is out of range for %d vertices.\n", edges[i].src, edges[i].dest, vertices);
+            exit(1);
+        }
+        g->offsets[edges[i].src + 1]++;
+        if (!directed)
+        {
+            g->offsets[edges[i].dest + 1]++;
+        }
+    }
+    for (int v = 0; v < vertices; v++)
+    {
+        g->offsets[v + 1] += g->offsets[v];
+    }
+
+    g->arcs = g->offsets[vertices];
+    g->targets = (int *)allocate(g->arcs * sizeof(int));
+    g->weights = (int *)allocate(g->arcs * sizeof(int));
+
+    long *cursor = (long *)allocate(vertices * sizeof(long));
+    for (int v = 0; v < vertices; v++)
+    {
+        cursor[v] = g->offsets[v];
+    }
+    for (long i = 0; i < edgeCount; i++)
+    {
+        long slot = cursor[edges[i].src]++;
+        g->targets[slot] = edges[i].dest;
+        g->weights[slot] = edges[i].weight;
+        if (!directed)
+        {
+            slot = cursor[edges[i].dest]++;
+            g->targets[slot] = edges[i].src;
+            g->weights[slot] = edges[i].weight;
+        }
+    }
+    free(cursor);
+    return g;
+}
+
+// Release a graph built by buildGraph or opened by mapGraph
+void freeGraph(Graph *g)
+{
+    if (g == NULL)
+    {
+        return;
+    }
+    if (g->mapping != NULL)
+    {
+        munmap(g->mapping, g->mappingSize);
+    }
+    else
+    {
+        free(g->offsets);
+        free(g->targets);
+        free(g->weights);
+    }
+    free(g->originalIds);
+    free(g->internalIds);
+    free(g);
+}
+
+// Vertex id used inside a (possibly reordered) graph for a caller's id
+int internalVertex(Graph *g, int original)
+{
+    return g->internalIds != NULL ? g->internalIds[original] : original;
+}
+
+// Caller's id of a vertex inside a (possibly reordered) graph
+int originalVertex(Graph *g, int internal)
+{
+    return g->originalIds != NULL ? g->originalIds[internal] : internal;
+}
+
+// Binary graph file: a header followed by the offsets, targets and weights
+// arrays, each starting on a GRAPH_FILE_ALIGNMENT boundary so a mapped file
+// can be used in place
+#define GRAPH_FILE_MAGIC "CSRGRAPH"
+#define GRAPH_FILE_VERSION 1
+#define GRAPH_FILE_ALIGNMENT 64
+
+typedef struct GraphFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t directed;
+    uint64_t vertices;
+    uint64_t arcs;
+    uint64_t offsetsStart; // Byte positions of the sections
+    uint64_t targetsStart;
+    uint64_t weightsStart;
+    uint64_t fileSize;
+} GraphFileHeader;
+
+// Round a byte position up to the section alignment
+uint64_t alignSection(uint64_t position)
+{
+    return (position + GRAPH_FILE_ALIGNMENT - 1) & ~(uint64_t)(GRAPH_FILE_ALIGNMENT - 1);
+}
+
+// Write zero bytes until the file reaches the given position
+int padFile(FILE *file, uint64_t position)
+{
+    static const char zeros[GRAPH_FILE_ALIGNMENT] = {0};
+    long current = ftell(file);
+    return current >= 0 && fwrite(zeros, 1, position - (uint64_t)current, file) == position - (uint64_t)current;
+}
+
+// Save a graph in the binary format; returns 1 on success
+int saveGraph(Graph *g, const char *path)
+{
+    GraphFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FILE_VERSION;
+    header.directed = (uint32_t)g->directed;
+    header.vertices = (uint64_t)g->vertices;
+    header.arcs = (uint64_t)g->arcs;
+    header.offsetsStart = alignSection(sizeof(header));
+    header.targetsStart = alignSection(header.offsetsStart + (header.vertices + 1) * sizeof(int64_t));
+    header.weightsStart = alignSection(header.targetsStart + header.arcs * sizeof(int32_t));
+    header.fileSize = header.weightsStart + header.arcs * sizeof(int32_t);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        printf("Cannot open %s for writing.\n", path);
+        return 0;
+    }
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && padFile(file, header.offsetsStart);
+    for (int v = 0; ok && v <= g->vertices; v++)
+    {
+        int64_t offset = g->offsets[v];
+        ok = fwrite(&offset, sizeof(offset), 1, file) == 1;
+    }
+    ok = ok && padFile(file, header.targetsStart);
+    ok = ok && fwrite(g->targets, sizeof(int), g->arcs, file) == (size_t)g->arcs;
+    ok = ok && padFile(file, header.weightsStart);
+    ok = ok && fwrite(g->weights, sizeof(int), g->arcs, file) == (size_t)g->arcs;
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+    {
+        printf("Failed to write graph file %s.\n", path);
+    }
+    return ok;
+}
+
+// Whether mapped CSR arrays describe a graph: offsets start at 0, never
+// decrease and end at the arc count, and every target is a vertex
+int validCsrArrays(const int64_t *offsets, const int32_t *targets, uint64_t vertices, uint64_t arcs)
+{
+    if (offsets[0] != 0 || offsets[vertices] != (int64_t)arcs)
+    {
+        return 0;
+    }
+    for (uint64_t v = 0; v < vertices; v++)
+    {
+        if (offsets[v] > offsets[v + 1])
+        {
+            return 0;
+        }
+    }
+    for (uint64_t i = 0; i < arcs; i++)
+    {
+        if (targets[i] < 0 || (uint64_t)targets[i] >= vertices)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
 
-// Function to create a new adjacency list node
-Node *createNode(int vertex)
+// Open a binary graph file as a read-only graph without copying: the arrays
+// point straight into a shared mapping of the file. The file is checked once
+// here, which reads every offset and target. Returns NULL on error.
+Graph *mapGraph(const char *path)
 {
-    Node *newNode = (Node *)malloc(sizeof(Node));
-    newNode->vertex = vertex;
-    newNode->next = NULL;
-    return newNode;
+    if (sizeof(long) != sizeof(int64_t) || sizeof(int) != sizeof(int32_t))
+    {
+        printf("Mapped graphs need 64-bit longs and 32-bit ints.\n");
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("Cannot open graph file %s.\n", path);
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(GraphFileHeader))
+    {
+        printf("Graph file %s is truncated.\n", path);
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        printf("Cannot map graph file %s.\n", path);
+        return NULL;
+    }
+
+    // Sections must be aligned, ordered and inside the file, and the arrays
+    // must form a CSR graph, or traversals would read out of bounds
+    const GraphFileHeader *header = (const GraphFileHeader *)mapping;
+    if (memcmp(header->magic, GRAPH_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != GRAPH_FILE_VERSION || header->directed > 1 || header->fileSize > size ||
+        header->vertices >= INT_MAX || header->arcs > size ||
+        header->offsetsStart % GRAPH_FILE_ALIGNMENT != 0 || header->targetsStart % GRAPH_FILE_ALIGNMENT != 0 ||
+        header->weightsStart % GRAPH_FILE_ALIGNMENT != 0 || header->offsetsStart < sizeof(GraphFileHeader) ||
+        header->offsetsStart > size || header->targetsStart > size || header->weightsStart > size ||
+        header->offsetsStart + (header->vertices + 1) * sizeof(int64_t) > header->targetsStart ||
+        header->targetsStart + header->arcs * sizeof(int32_t) > header->weightsStart ||
+        header->weightsStart + header->arcs * sizeof(int32_t) > header->fileSize ||
+        !validCsrArrays((const int64_t *)((char *)mapping + header->offsetsStart),
+                        (const int32_t *)((char *)mapping + header->targetsStart), header->vertices, header->arcs))
+    {
+        printf("%s is not a valid graph file.\n", path);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    Graph *g = (Graph *)allocate(sizeof(Graph));
+    g->vertices = (int)header->vertices;
+    g->directed = (int)header->directed;
+    g->arcs = (long)header->arcs;
+    g->offsets = (long *)((char *)mapping + header->offsetsStart);
+    g->targets = (int *)((char *)mapping + header->targetsStart);
+    g->weights = (int *)((char *)mapping + header->weightsStart);
+    g->mapping = mapping;
+    g->mappingSize = size;
+    g->originalIds = NULL;
+    g->internalIds = NULL;
+    return g;
 }
 
-// Add edge to adjacency list
-void addEdgeList(int u, int v)
+// Read a plain-text edge list with one "src dest [weight]" per line (weight
+// defaults to 1, lines starting with '#' are comments) into a CSR graph whose
+// vertex count is the largest id plus one. Returns NULL on error.
+Graph *loadEdgeListText(const char *path, int directed)
 {
-    Node *newNode = createNode(v);
-    newNode->next = adjList[u];
-    adjList[u] = newNode;
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        printf("Cannot open edge list %s.\n", path);
+        return NULL;
+    }
+
+    Edge *edges = NULL;
+    long count = 0, capacity = 0;
+    int vertices = 0;
+    char line[256];
+    long lineNumber = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+        Edge edge = {0, 0, 1};
+        int fields = sscanf(line, "%d %d %d", &edge.src, &edge.dest, &edge.weight);
+        if (line[0] == '#' || fields == EOF)
+        {
+            continue;
+        }
+        if (fields < 2 || edge.src < 0 || edge.dest < 0)
+        {
+            printf("%s:%ld: expected \"src dest [weight]\".\n", path, lineNumber);
+            free(edges);
+            fclose(file);
+            return NULL;
+        }
+        if (count == capacity)
+        {
+            capacity = capacity > 0 ? capacity * 2 : 1024;
+            Edge *grown = (Edge *)realloc(edges, capacity * sizeof(Edge));
+            if (grown == NULL)
+            {
+                printf("Memory allocation failed.\n");
+                exit(1);
+            }
+            edges = grown;
+        }
+        edges[count++] = edge;
+        if (edge.src >= vertices)
+        {
+            vertices = edge.src + 1;
+        }
+        if (edge.dest >= vertices)
+        {
+            vertices = edge.dest + 1;
+        }
+    }
+    fclose(file);
+
+    Graph *g = buildGraph(edges, count, vertices, directed);
+    free(edges);
+    return g;
+}
 
-    newNode = createNode(u); // For undirected graph
-    newNode->next = adjList[v];
-    adjList[v] = newNode;
+// Convert a text edge list into the binary graph format; returns 1 on success
+int convertEdgeList(const char *textPath, const char *binaryPath, int directed)
+{
+    Graph *g = loadEdgeListText(textPath, directed);
+    if (g == NULL)
+    {
+        return 0;
+    }
+    int ok = saveGraph(g, binaryPath);
+    if (ok)
+    {
+        printf("Wrote %s: %d vertices, %ld arcs.\n", binaryPath, g->vertices, g->arcs);
+    }
+    freeGraph(g);
+    return ok;
 }
 
 // BFS Traversal
-void BFS(int start, int vertices)
+void BFS(Graph *g, int start)
 {
-    int visited[MAX] = {0};
-    int queue[MAX], front = 0, rear = 0;
+    char *visited = (char *)allocateZeroed(g->vertices, sizeof(char));
+    int *queue = (int *)allocate(g->vertices * sizeof(int));
+    int front = 0, rear = 0;
 
+    start = internalVertex(g, start);
     visited[start] = 1;
     queue[rear++] = start;
 
@@ -63,177 +450,2734 @@ void BFS(int start, int vertices)
     while (front < rear)
     {
         int current = queue[front++];
-        printf("%d ", current);
+        printf("%d ", originalVertex(g, current));
 
-        for (Node *temp = adjList[current]; temp != NULL; temp = temp->next)
+        for (long e = g->offsets[current]; e < g->offsets[current + 1]; e++)
         {
-            if (!visited[temp->vertex])
+            int next = g->targets[e];
+            if (!visited[next])
             {
-                visited[temp->vertex] = 1;
-                queue[rear++] = temp->vertex;
+                visited[next] = 1;
+                queue[rear++] = next;
             }
         }
     }
     printf("\n");
+
+    free(queue);
+    free(visited);
 }
 
-// DFS Traversal
-void DFSUtil(int vertex, int visited[])
+// Switch the direction-optimizing BFS to bottom-up once the frontier's arcs
+// exceed 1/BFS_ALPHA of the unexplored arcs, and back to top-down once the
+// frontier holds fewer than 1/BFS_BETA of the vertices
+#define BFS_ALPHA 14
+#define BFS_BETA 24
+
+// Number of 64-bit words needed for a bitmap over n vertices
+long bitmapWords(int n)
 {
-    printf("%d ", vertex);
-    visited[vertex] = 1;
+    return ((long)n + 63) / 64;
+}
 
-    for (Node *temp = adjList[vertex]; temp != NULL; temp = temp->next)
-    {
-        if (!visited[temp->vertex])
-        {
-            DFSUtil(temp->vertex, visited);
-        }
-    }
+// Check whether bit i is set in a bitmap
+int testBit(const uint64_t bits[], int i)
+{
+    return (bits[i >> 6] >> (i & 63)) & 1;
 }
 
-void DFS(int start, int vertices)
+// Out-degree of a vertex
+long degree(Graph *g, int v)
 {
-    int visited[MAX] = {0};
-    printf("DFS Traversal: ");
-    DFSUtil(start, visited);
-    printf("\n");
+    return g->offsets[v + 1] - g->offsets[v];
 }
 
-// Dijkstra's Shortest Path
-void dijkstra(int start, int vertices)
+// Direction-optimizing BFS (Beamer et al.) with bitmap frontiers. Fills
+// parent[] (-1 for the source and unreached vertices) and level[] (-1 when
+// unreached). Bottom-up sweeps scan the vertex's own arcs as in-arcs, so
+// directed graphs always run top-down. Like the printing traversals, the
+// source, the indices and the parents are the caller's ids on a reordered
+// graph.
+void bfsDirectionOptimizing(Graph *g, int source, int parent[], int level[])
 {
-    int dist[MAX], visited[MAX] = {0};
+    int n = g->vertices;
+    long words = bitmapWords(n);
+    uint64_t *visited = (uint64_t *)allocateZeroed(words, sizeof(uint64_t));
+    uint64_t *frontier = (uint64_t *)allocateZeroed(words, sizeof(uint64_t));
+    uint64_t *next = (uint64_t *)allocateZeroed(words, sizeof(uint64_t));
 
-    for (int i = 0; i < vertices; i++)
+    for (int i = 0; i < n; i++)
     {
-        dist[i] = INT_MAX;
+        parent[i] = -1;
+        level[i] = -1;
     }
-    dist[start] = 0;
+    source = internalVertex(g, source);
+    level[source] = 0;
+    visited[source >> 6] |= 1ULL << (source & 63);
+    frontier[source >> 6] |= 1ULL << (source & 63);
 
-    for (int i = 0; i < vertices; i++)
+    long frontierVertices = 1;
+    long frontierArcs = degree(g, source);
+    long unexploredArcs = g->arcs - frontierArcs;
+    int bottomUp = 0;
+    int depth = 0;
+
+    while (frontierVertices > 0)
     {
-        int u = -1;
-        for (int j = 0; j < vertices; j++)
+        if (!g->directed)
         {
-            if (!visited[j] && (u == -1 || dist[j] < dist[u]))
+            if (!bottomUp && frontierArcs > unexploredArcs / BFS_ALPHA)
+            {
+                bottomUp = 1;
+            }
+            else if (bottomUp && frontierVertices < n / BFS_BETA)
             {
-                u = j;
+                bottomUp = 0;
             }
         }
 
-        visited[u] = 1;
+        memset(next, 0, words * sizeof(uint64_t));
+        long nextVertices = 0, nextArcs = 0;
+        depth++;
 
-        for (int v = 0; v < vertices; v++)
+        if (bottomUp)
+        {
+            // Every unvisited vertex looks for any parent in the frontier; one
+            // thread owns each bitmap word, so no atomics are needed
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : nextVertices, nextArcs)
+            for (long w = 0; w < words; w++)
+            {
+                uint64_t unvisited = ~visited[w];
+                if (w == words - 1 && (n & 63) != 0)
+                {
+                    unvisited &= (1ULL << (n & 63)) - 1;
+                }
+                uint64_t found = 0;
+                while (unvisited != 0)
+                {
+                    int bit = __builtin_ctzll(unvisited);
+                    unvisited &= unvisited - 1;
+                    int v = (int)(w * 64 + bit);
+                    for (long e = g->offsets[v]; e < g->offsets[v + 1]; e++)
+                    {
+                        int u = g->targets[e];
+                        if (testBit(frontier, u))
+                        {
+                            parent[v] = u;
+                            level[v] = depth;
+                            found |= 1ULL << bit;
+                            nextVertices++;
+                            nextArcs += degree(g, v);
+                            break;
+                        }
+                    }
+                }
+                next[w] = found;
+                visited[w] |= found;
+            }
+        }
+        else
         {
-            if (graph[u][v] && dist[u] != INT_MAX && dist[u] + graph[u][v] < dist[v])
+            // Frontier vertices claim their unvisited neighbors with an atomic OR
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : nextVertices, nextArcs)
+            for (long w = 0; w < words; w++)
             {
-                dist[v] = dist[u] + graph[u][v];
+                uint64_t bits = frontier[w];
+                while (bits != 0)
+                {
+                    int u = (int)(w * 64 + __builtin_ctzll(bits));
+                    bits &= bits - 1;
+                    for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+                    {
+                        int v = g->targets[e];
+                        uint64_t mask = 1ULL << (v & 63);
+                        if (__atomic_load_n(&visited[v >> 6], __ATOMIC_RELAXED) & mask)
+                        {
+                            continue;
+                        }
+                        if (!(__atomic_fetch_or(&visited[v >> 6], mask, __ATOMIC_RELAXED) & mask))
+                        {
+                            parent[v] = u;
+                            level[v] = depth;
+                            __atomic_fetch_or(&next[v >> 6], mask, __ATOMIC_RELAXED);
+                            nextVertices++;
+                            nextArcs += degree(g, v);
+                        }
+                    }
+                }
             }
         }
+
+        uint64_t *swap = frontier;
+        frontier = next;
+        next = swap;
+        frontierVertices = nextVertices;
+        frontierArcs = nextArcs;
+        unexploredArcs -= nextArcs;
     }
 
-    printf("Dijkstra's Shortest Path (from vertex %d):\n", start);
-    for (int i = 0; i < vertices; i++)
+    // The sweeps ran on internal ids; reindex by the caller's ids
+    if (g->originalIds != NULL)
     {
-        printf("Vertex %d: %d\n", i, dist[i]);
+        int *internalParent = (int *)allocate(n * sizeof(int));
+        int *internalLevel = (int *)allocate(n * sizeof(int));
+        memcpy(internalParent, parent, n * sizeof(int));
+        memcpy(internalLevel, level, n * sizeof(int));
+        for (int v = 0; v < n; v++)
+        {
+            int original = originalVertex(g, v);
+            parent[original] = internalParent[v] >= 0 ? originalVertex(g, internalParent[v]) : -1;
+            level[original] = internalLevel[v];
+        }
+        free(internalLevel);
+        free(internalParent);
     }
+
+    free(next);
+    free(frontier);
+    free(visited);
 }
 
-// Kruskal's Algorithm Helper Functions
-int find(Subset subsets[], int i)
+// Sources that share one sweep of the multi-source BFS
+#define MSBFS_BATCH 64
+
+// Bit-parallel multi-source BFS (Then et al., "The More the Merrier"). Sources
+// are processed in batches of 64; every vertex carries a bitmask of the batch
+// sources that have reached it, so each arc is scanned once per level for the
+// whole batch instead of once per source. dist[i * g->vertices + v] receives
+// the hop distance from sources[i] to v, or -1 if v is unreachable. Like the
+// printing traversals, sources and v are the caller's ids on a reordered graph.
+void multiSourceBfs(Graph *g, const int sources[], int count, int dist[])
 {
-    if (subsets[i].parent != i)
+    int n = g->vertices;
+    uint64_t *seen = (uint64_t *)allocate(n * sizeof(uint64_t));
+    uint64_t *visit = (uint64_t *)allocate(n * sizeof(uint64_t));
+    uint64_t *visitNext = (uint64_t *)allocate(n * sizeof(uint64_t));
+
+    for (long i = 0; i < (long)count * n; i++)
+    {
+        dist[i] = -1;
+    }
+
+    for (int base = 0; base < count; base += MSBFS_BATCH)
     {
-        subsets[i].parent = find(subsets, subsets[i].parent);
+        int batch = count - base < MSBFS_BATCH ? count - base : MSBFS_BATCH;
+        memset(seen, 0, n * sizeof(uint64_t));
+        memset(visit, 0, n * sizeof(uint64_t));
+        memset(visitNext, 0, n * sizeof(uint64_t));
+        for (int i = 0; i < batch; i++)
+        {
+            int source = internalVertex(g, sources[base + i]);
+            seen[source] |= 1ULL << i;
+            visit[source] |= 1ULL << i;
+            dist[(long)(base + i) * n + sources[base + i]] = 0;
+        }
+
+        long active = 1;
+        for (int level = 1; active > 0; level++)
+        {
+            // Push every vertex's active sources to its neighbors
+#pragma omp parallel for schedule(dynamic, 256)
+            for (int u = 0; u < n; u++)
+            {
+                uint64_t sourcesHere = visit[u];
+                if (sourcesHere == 0)
+                {
+                    continue;
+                }
+                for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+                {
+                    int v = g->targets[e];
+                    if ((sourcesHere & ~__atomic_load_n(&visitNext[v], __ATOMIC_RELAXED)) != 0)
+                    {
+                        __atomic_fetch_or(&visitNext[v], sourcesHere, __ATOMIC_RELAXED);
+                    }
+                }
+            }
+
+            // Keep only sources that reach a vertex for the first time
+            active = 0;
+#pragma omp parallel for schedule(static) reduction(+ : active)
+            for (int v = 0; v < n; v++)
+            {
+                uint64_t discovered = visitNext[v] & ~seen[v];
+                visitNext[v] = 0;
+                visit[v] = discovered;
+                if (discovered == 0)
+                {
+                    continue;
+                }
+                seen[v] |= discovered;
+                active++;
+                int original = originalVertex(g, v);
+                while (discovered != 0)
+                {
+                    int i = __builtin_ctzll(discovered);
+                    discovered &= discovered - 1;
+                    dist[(long)(base + i) * n + original] = level;
+                }
+            }
+        }
     }
-    return subsets[i].parent;
+
+    free(visitNext);
+    free(visit);
+    free(seen);
 }
 
-void Union(Subset subsets[], int x, int y)
+// Vertex colors used by the DFS engine
+#define WHITE 0 // Not discovered yet
+#define GRAY 1  // Discovered, still on the DFS stack
+#define BLACK 2 // Finished
+
+// Callbacks invoked by the DFS engine; any of them may be NULL. nonTreeEdge
+// reports arcs to vertices that were already discovered (GRAY or BLACK).
+typedef struct DfsVisitor
 {
-    int rootX = find(subsets, x);
-    int rootY = find(subsets, y);
+    void (*discover)(int vertex, void *context);
+    void (*finish)(int vertex, int parent, void *context);
+    void (*nonTreeEdge)(int from, int to, void *context);
+    void *context;
+} DfsVisitor;
 
-    if (subsets[rootX].rank < subsets[rootY].rank)
+// One frame of the explicit DFS stack: a vertex and the next arc to scan,
+// so every adjacency list is walked exactly once
+typedef struct DfsFrame
+{
+    int vertex;
+    long nextArc;
+} DfsFrame;
+
+// Iterative DFS from a WHITE start vertex. frames[] must have room for
+// g->vertices entries; color[] is updated and shared between calls.
+void dfsVisit(Graph *g, int start, char color[], DfsFrame frames[], DfsVisitor *visitor)
+{
+    int top = 0;
+    color[start] = GRAY;
+    frames[0].vertex = start;
+    frames[0].nextArc = g->offsets[start];
+    if (visitor->discover)
     {
-        subsets[rootX].parent = rootY;
+        visitor->discover(start, visitor->context);
     }
-    else if (subsets[rootX].rank > subsets[rootY].rank)
+
+    while (top >= 0)
     {
-        subsets[rootY].parent = rootX;
+        DfsFrame *frame = &frames[top];
+        int u = frame->vertex;
+        if (frame->nextArc < g->offsets[u + 1])
+        {
+            int v = g->targets[frame->nextArc++];
+            if (color[v] == WHITE)
+            {
+                color[v] = GRAY;
+                top++;
+                frames[top].vertex = v;
+                frames[top].nextArc = g->offsets[v];
+                if (visitor->discover)
+                {
+                    visitor->discover(v, visitor->context);
+                }
+            }
+            else if (visitor->nonTreeEdge)
+            {
+                visitor->nonTreeEdge(u, v, visitor->context);
+            }
+        }
+        else
+        {
+            color[u] = BLACK;
+            top--;
+            if (visitor->finish)
+            {
+                visitor->finish(u, top >= 0 ? frames[top].vertex : -1, visitor->context);
+            }
+        }
     }
-    else
+}
+
+// Run the DFS engine from every WHITE vertex in index order and return the
+// number of DFS trees started
+int dfsForest(Graph *g, char color[], DfsVisitor *visitor)
+{
+    DfsFrame *frames = (DfsFrame *)allocate(g->vertices * sizeof(DfsFrame));
+    int trees = 0;
+    for (int v = 0; v < g->vertices; v++)
     {
-        subsets[rootY].parent = rootX;
-        subsets[rootX].rank++;
+        if (color[v] == WHITE)
+        {
+            dfsVisit(g, v, color, frames, visitor);
+            trees++;
+        }
     }
+    free(frames);
+    return trees;
 }
 
-// Kruskal's Algorithm
-int compareEdges(const void *a, const void *b)
+// DFS Traversal
+void printDiscovered(int vertex, void *context)
 {
-    return ((Edge *)a)->weight - ((Edge *)b)->weight;
+    printf("%d ", originalVertex((Graph *)context, vertex));
 }
 
-void kruskal(Edge edges[], int vertices, int edgeCount)
+void DFS(Graph *g, int start)
 {
-    Subset subsets[MAX];
-    for (int i = 0; i < vertices; i++)
+    char *color = (char *)allocateZeroed(g->vertices, sizeof(char));
+    DfsFrame *frames = (DfsFrame *)allocate(g->vertices * sizeof(DfsFrame));
+    DfsVisitor visitor = {printDiscovered, NULL, NULL, g};
+
+    printf("DFS Traversal: ");
+    dfsVisit(g, internalVertex(g, start), color, frames, &visitor);
+    printf("\n");
+
+    free(frames);
+    free(color);
+}
+
+// State shared by the topological sort callbacks
+typedef struct TopologicalState
+{
+    int *order;
+    int position;
+    char *color;
+    int cyclic;
+} TopologicalState;
+
+void topologicalFinish(int vertex, int parent, void *context)
+{
+    (void)parent;
+    TopologicalState *state = (TopologicalState *)context;
+    state->order[--state->position] = vertex;
+}
+
+void topologicalEdge(int from, int to, void *context)
+{
+    (void)from;
+    TopologicalState *state = (TopologicalState *)context;
+    if (state->color[to] == GRAY)
     {
-        subsets[i].parent = i;
-        subsets[i].rank = 0;
+        state->cyclic = 1; // Back edge
     }
+}
+
+// Topological order of a directed graph (reverse finish order). Returns 1 on
+// success, or 0 if the graph has a cycle and no order exists.
+int topologicalSort(Graph *g, int order[])
+{
+    char *color = (char *)allocateZeroed(g->vertices, sizeof(char));
+    TopologicalState state = {order, g->vertices, color, 0};
+    DfsVisitor visitor = {NULL, topologicalFinish, topologicalEdge, &state};
 
-    qsort(edges, edgeCount, sizeof(Edge), compareEdges);
+    dfsForest(g, color, &visitor);
 
-    printf("Kruskal's Minimum Spanning Tree:\n");
-    for (int i = 0, count = 0; count < vertices - 1 && i < edgeCount; i++)
+    free(color);
+    return !state.cyclic;
+}
+
+// Check whether a graph contains a cycle. Directed graphs look for back
+// edges; an undirected forest has exactly vertices - trees edges.
+int hasCycle(Graph *g)
+{
+    if (g->directed)
     {
-        Edge nextEdge = edges[i];
+        int *order = (int *)allocate(g->vertices * sizeof(int));
+        int acyclic = topologicalSort(g, order);
+        free(order);
+        return !acyclic;
+    }
 
-        int x = find(subsets, nextEdge.src);
-        int y = find(subsets, nextEdge.dest);
+    char *color = (char *)allocateZeroed(g->vertices, sizeof(char));
+    DfsVisitor visitor = {NULL, NULL, NULL, NULL};
+    int trees = dfsForest(g, color, &visitor);
+    free(color);
+    return g->arcs / 2 > g->vertices - trees;
+}
 
-        if (x != y)
+// State for Tarjan's strongly connected components
+typedef struct TarjanState
+{
+    int *index;
+    int *low;
+    int *stack;
+    char *onStack;
+    int *component;
+    int counter;
+    int top;
+    int components;
+} TarjanState;
+
+void tarjanDiscover(int vertex, void *context)
+{
+    TarjanState *state = (TarjanState *)context;
+    state->index[vertex] = state->low[vertex] = state->counter++;
+    state->stack[state->top++] = vertex;
+    state->onStack[vertex] = 1;
+}
+
+void tarjanEdge(int from, int to, void *context)
+{
+    TarjanState *state = (TarjanState *)context;
+    if (state->onStack[to] && state->index[to] < state->low[from])
+    {
+        state->low[from] = state->index[to];
+    }
+}
+
+void tarjanFinish(int vertex, int parent, void *context)
+{
+    TarjanState *state = (TarjanState *)context;
+    if (state->low[vertex] == state->index[vertex])
+    {
+        int member;
+        do
         {
-            printf("Edge (%d, %d) with weight %d\n", nextEdge.src, nextEdge.dest, nextEdge.weight);
-            Union(subsets, x, y);
-            count++;
-        }
+            member = state->stack[--state->top];
+            state->onStack[member] = 0;
+            state->component[member] = state->components;
+        } while (member != vertex);
+        state->components++;
+    }
+    if (parent >= 0 && state->low[vertex] < state->low[parent])
+    {
+        state->low[parent] = state->low[vertex];
     }
 }
 
-// Main Function
-int main()
+// Tarjan's strongly connected components on the iterative DFS engine. Fills
+// component[] with ids in reverse topological order and returns their count.
+int stronglyConnectedComponents(Graph *g, int component[])
 {
-    int vertices = 6;
+    int n = g->vertices;
+    char *color = (char *)allocateZeroed(n, sizeof(char));
+    TarjanState state;
+    state.index = (int *)allocate(n * sizeof(int));
+    state.low = (int *)allocate(n * sizeof(int));
+    state.stack = (int *)allocate(n * sizeof(int));
+    state.onStack = (char *)allocateZeroed(n, sizeof(char));
+    state.component = component;
+    state.counter = 0;
+    state.top = 0;
+    state.components = 0;
+    DfsVisitor visitor = {tarjanDiscover, tarjanFinish, tarjanEdge, &state};
 
-    // Adjacency List Edges
-    addEdgeList(0, 1);
-    addEdgeList(0, 2);
-    addEdgeList(1, 3);
-    addEdgeList(2, 4);
-    addEdgeList(3, 5);
+    dfsForest(g, color, &visitor);
 
-    // Adjacency Matrix for Weighted Graph (for Dijkstra's)
-    graph[0][1] = 2;
-    graph[0][2] = 4;
-    graph[1][3] = 1;
-    graph[2][4] = 3;
-    graph[3][5] = 7;
+    free(state.onStack);
+    free(state.stack);
+    free(state.low);
+    free(state.index);
+    free(color);
+    return state.components;
+}
 
-    // BFS and DFS Traversals
-    BFS(0, vertices);
-    DFS(0, vertices);
+// Distance reported for vertices that cannot be reached
+#define INF_DISTANCE LLONG_MAX
 
-    // Dijkstra's Algorithm
-    dijkstra(0, vertices);
+// Children per node in the Dijkstra heap (2 gives a binary heap)
+#define HEAP_ARITY 4
 
-    // Kruskal's MST
-    Edge edges[] = {
-        {0, 1, 2}, {0, 2, 4}, {1, 3, 1}, {2, 4, 3}, {3, 5, 7}};
-    kruskal(edges, vertices, 5);
+// Number of buckets in a radix heap over 64-bit keys
+#define RADIX_BUCKETS 65
+
+// Entry stored in the shortest-path priority queues
+typedef struct HeapEntry
+{
+    long long key;
+    int vertex;
+} HeapEntry;
+
+// d-ary min-heap without decrease-key: a vertex is pushed again whenever its
+// distance improves and stale entries are skipped when they are popped
+typedef struct DaryHeap
+{
+    HeapEntry *entries;
+    long size;
+    long capacity;
+} DaryHeap;
+
+// Radix heap for monotone integer keys: bucket i holds keys whose highest bit
+// differing from the last extracted minimum is bit i - 1
+typedef struct RadixHeap
+{
+    HeapEntry *buckets[RADIX_BUCKETS];
+    long sizes[RADIX_BUCKETS];
+    long capacities[RADIX_BUCKETS];
+    unsigned long long last;
+    long size;
+} RadixHeap;
+
+// Append an entry to a growable entry array
+void appendEntry(HeapEntry **entries, long *size, long *capacity, HeapEntry entry)
+{
+    if (*size == *capacity)
+    {
+        *capacity = *capacity > 0 ? *capacity * 2 : 16;
+        HeapEntry *grown = (HeapEntry *)realloc(*entries, *capacity * sizeof(HeapEntry));
+        if (grown == NULL)
+        {
+            printf("Memory allocation failed.\n");
+            exit(1);
+        }
+        *entries = grown;
+    }
+    (*entries)[(*size)++] = entry;
+}
+
+// Push an entry and sift it up towards the root
+void heapPush(DaryHeap *heap, long long key, int vertex)
+{
+    HeapEntry entry = {key, vertex};
+    appendEntry(&heap->entries, &heap->size, &heap->capacity, entry);
+
+    long i = heap->size - 1;
+    while (i > 0)
+    {
+        long parent = (i - 1) / HEAP_ARITY;
+        if (heap->entries[parent].key <= key)
+        {
+            break;
+        }
+        heap->entries[i] = heap->entries[parent];
+        i = parent;
+    }
+    heap->entries[i] = entry;
+}
+
+// Remove and return the minimum entry; the heap must not be empty
+HeapEntry heapPop(DaryHeap *heap)
+{
+    HeapEntry top = heap->entries[0];
+    HeapEntry last = heap->entries[--heap->size];
+
+    long i = 0;
+    while (1)
+    {
+        long first = i * HEAP_ARITY + 1;
+        if (first >= heap->size)
+        {
+            break;
+        }
+        long end = first + HEAP_ARITY < heap->size ? first + HEAP_ARITY : heap->size;
+        long smallest = first;
+        for (long c = first + 1; c < end; c++)
+        {
+            if (heap->entries[c].key < heap->entries[smallest].key)
+            {
+                smallest = c;
+            }
+        }
+        if (last.key <= heap->entries[smallest].key)
+        {
+            break;
+        }
+        heap->entries[i] = heap->entries[smallest];
+        i = smallest;
+    }
+    if (heap->size > 0)
+    {
+        heap->entries[i] = last;
+    }
+    return top;
+}
+
+// Bucket index of a key relative to the last extracted minimum
+int radixBucket(unsigned long long key, unsigned long long last)
+{
+    return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+}
+
+// Push a key that is not smaller than the last extracted minimum
+void radixPush(RadixHeap *heap, unsigned long long key, int vertex)
+{
+    int b = radixBucket(key, heap->last);
+    HeapEntry entry = {(long long)key, vertex};
+    appendEntry(&heap->buckets[b], &heap->sizes[b], &heap->capacities[b], entry);
+    heap->size++;
+}
+
+// Remove and return a minimum entry; the heap must not be empty
+HeapEntry radixPop(RadixHeap *heap)
+{
+    if (heap->sizes[0] == 0)
+    {
+        int b = 1;
+        while (heap->sizes[b] == 0)
+        {
+            b++;
+        }
+
+        // The new minimum redistributes its whole bucket into lower buckets
+        unsigned long long minimum = (unsigned long long)heap->buckets[b][0].key;
+        for (long i = 1; i < heap->sizes[b]; i++)
+        {
+            if ((unsigned long long)heap->buckets[b][i].key < minimum)
+            {
+                minimum = (unsigned long long)heap->buckets[b][i].key;
+            }
+        }
+        heap->last = minimum;
+        for (long i = 0; i < heap->sizes[b]; i++)
+        {
+            HeapEntry entry = heap->buckets[b][i];
+            int target = radixBucket((unsigned long long)entry.key, minimum);
+            appendEntry(&heap->buckets[target], &heap->sizes[target], &heap->capacities[target], entry);
+        }
+        heap->sizes[b] = 0;
+    }
+    heap->size--;
+    return heap->buckets[0][--heap->sizes[0]];
+}
+
+// Release the buckets of a radix heap
+void radixFree(RadixHeap *heap)
+{
+    for (int b = 0; b < RADIX_BUCKETS; b++)
+    {
+        free(heap->buckets[b]);
+    }
+}
+
+// Reset the distance and parent arrays before a shortest-path search
+void initShortestPaths(Graph *g, int start, long long dist[], int parent[])
+{
+    for (int i = 0; i < g->vertices; i++)
+    {
+        dist[i] = INF_DISTANCE;
+        parent[i] = -1;
+    }
+    dist[start] = 0;
+}
+
+// Heap-based Dijkstra over the CSR graph; fills dist[] and the shortest-path
+// tree in parent[] (-1 for the source and for unreachable vertices)
+void dijkstraHeap(Graph *g, int start, long long dist[], int parent[])
+{
+    DaryHeap heap = {NULL, 0, 0};
+    initShortestPaths(g, start, dist, parent);
+    heapPush(&heap, 0, start);
+
+    while (heap.size > 0)
+    {
+        HeapEntry top = heapPop(&heap);
+        int u = top.vertex;
+        if (top.key != dist[u])
+        {
+            continue; // Stale entry left behind by a later improvement
+        }
+
+        for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+        {
+            int v = g->targets[e];
+            long long candidate = dist[u] + g->weights[e];
+            if (candidate < dist[v])
+            {
+                dist[v] = candidate;
+                parent[v] = u;
+                heapPush(&heap, candidate, v);
+            }
+        }
+    }
+    free(heap.entries);
+}
+
+// Dijkstra driven by a radix heap; requires non-negative integer weights
+void dijkstraRadix(Graph *g, int start, long long dist[], int parent[])
+{
+    RadixHeap heap = {{NULL}, {0}, {0}, 0, 0};
+    initShortestPaths(g, start, dist, parent);
+    radixPush(&heap, 0, start);
+
+    while (heap.size > 0)
+    {
+        HeapEntry top = radixPop(&heap);
+        int u = top.vertex;
+        if (top.key != dist[u])
+        {
+            continue;
+        }
+
+        for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+        {
+            if (g->weights[e] < 0)
+            {
+                printf("Radix heap Dijkstra requires non-negative weights.\n");
+                exit(1);
+            }
+            int v = g->targets[e];
+            long long candidate = dist[u] + g->weights[e];
+            if (candidate < dist[v])
+            {
+                dist[v] = candidate;
+                parent[v] = u;
+                radixPush(&heap, (unsigned long long)candidate, v);
+            }
+        }
+    }
+    radixFree(&heap);
+}
+
+// Growable list of vertex ids
+typedef struct VertexList
+{
+    int *items;
+    long size;
+    long capacity;
+} VertexList;
+
+// Append a vertex to a list
+void appendVertex(VertexList *list, int vertex)
+{
+    if (list->size == list->capacity)
+    {
+        list->capacity = list->capacity > 0 ? list->capacity * 2 : 16;
+        int *grown = (int *)realloc(list->items, list->capacity * sizeof(int));
+        if (grown == NULL)
+        {
+            printf("Memory allocation failed.\n");
+            exit(1);
+        }
+        list->items = grown;
+    }
+    list->items[list->size++] = vertex;
+}
+
+// Atomically lower *target to value; returns 1 if this call lowered it
+int atomicMin(long long *target, long long value)
+{
+    long long current = __atomic_load_n(target, __ATOMIC_RELAXED);
+    while (value < current)
+    {
+        if (__atomic_compare_exchange_n(target, &current, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Buckets and scratch arrays of a delta-stepping run
+typedef struct DeltaState
+{
+    Graph *g;
+    long long delta;
+    long long *dist;
+    VertexList *buckets;
+    long bucketCount;
+    char *queued;      // Vertex is in changed[] for the current relaxation
+    int *changed;      // Vertices whose distance dropped in the last relaxation
+    long changedCount;
+} DeltaState;
+
+// Relax the light (weight <= delta) or heavy arcs of every vertex in
+// vertices[] in parallel, then file each improved vertex in its new bucket
+void relaxBucketArcs(DeltaState *state, const int vertices[], long count, int heavy)
+{
+    Graph *g = state->g;
+    long long *dist = state->dist;
+    long long delta = state->delta;
+    state->changedCount = 0;
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (long i = 0; i < count; i++)
+    {
+        int u = vertices[i];
+        long long du = __atomic_load_n(&dist[u], __ATOMIC_RELAXED);
+        for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+        {
+            if ((g->weights[e] > delta) != heavy)
+            {
+                continue;
+            }
+            int v = g->targets[e];
+            if (atomicMin(&dist[v], du + g->weights[e]) && !__atomic_exchange_n(&state->queued[v], 1, __ATOMIC_RELAXED))
+            {
+                state->changed[__atomic_fetch_add(&state->changedCount, 1, __ATOMIC_RELAXED)] = v;
+            }
+        }
+    }
+
+    for (long i = 0; i < state->changedCount; i++)
+    {
+        int v = state->changed[i];
+        state->queued[v] = 0;
+        long b = dist[v] / delta;
+        if (b >= state->bucketCount)
+        {
+            long grown = state->bucketCount * 2 > b + 1 ? state->bucketCount * 2 : b + 1;
+            VertexList *buckets = (VertexList *)realloc(state->buckets, grown * sizeof(VertexList));
+            if (buckets == NULL)
+            {
+                printf("Memory allocation failed.\n");
+                exit(1);
+            }
+            memset(buckets + state->bucketCount, 0, (grown - state->bucketCount) * sizeof(VertexList));
+            state->buckets = buckets;
+            state->bucketCount = grown;
+        }
+        appendVertex(&state->buckets[b], v);
+    }
+}
+
+// Parallel delta-stepping single-source shortest paths (Meyer & Sanders).
+// Vertices are kept in buckets of width delta; each bucket is emptied by
+// repeatedly relaxing light arcs, after which the heavy arcs of everything it
+// settled are relaxed once. Weights must be non-negative. A delta <= 0 picks
+// the average arc weight. Produces the same dist[] as dijkstraHeap.
+void deltaStepping(Graph *g, int start, long long delta, long long dist[])
+{
+    int n = g->vertices;
+    if (delta <= 0)
+    {
+        long long totalWeight = 0;
+        for (long e = 0; e < g->arcs; e++)
+        {
+            totalWeight += g->weights[e];
+        }
+        delta = g->arcs > 0 && totalWeight / g->arcs > 0 ? totalWeight / g->arcs : 1;
+    }
+    for (long e = 0; e < g->arcs; e++)
+    {
+        if (g->weights[e] < 0)
+        {
+            printf("Delta-stepping requires non-negative weights.\n");
+            exit(1);
+        }
+    }
+
+    DeltaState state;
+    state.g = g;
+    state.delta = delta;
+    state.dist = dist;
+    state.bucketCount = 1;
+    state.buckets = (VertexList *)allocateZeroed(1, sizeof(VertexList));
+    state.queued = (char *)allocateZeroed(n, sizeof(char));
+    state.changed = (int *)allocate(n * sizeof(int));
+    state.changedCount = 0;
+
+    long *frontierStamp = (long *)allocateZeroed(n, sizeof(long));
+    long *settledStamp = (long *)allocateZeroed(n, sizeof(long));
+    VertexList frontier = {NULL, 0, 0};
+    VertexList settled = {NULL, 0, 0};
+    long round = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        dist[i] = INF_DISTANCE;
+    }
+    dist[start] = 0;
+    appendVertex(&state.buckets[0], start);
+
+    for (long b = 0; b < state.bucketCount; b++)
+    {
+        settled.size = 0;
+        while (state.buckets[b].size > 0)
+        {
+            // Take the bucket, dropping duplicates and vertices that moved to
+            // a lower bucket after they were filed here
+            round++;
+            frontier.size = 0;
+            VertexList *bucket = &state.buckets[b];
+            for (long i = 0; i < bucket->size; i++)
+            {
+                int v = bucket->items[i];
+                if (dist[v] / delta == b && frontierStamp[v] != round)
+                {
+                    frontierStamp[v] = round;
+                    appendVertex(&frontier, v);
+                    if (settledStamp[v] != b + 1)
+                    {
+                        settledStamp[v] = b + 1;
+                        appendVertex(&settled, v);
+                    }
+                }
+            }
+            bucket->size = 0;
+            relaxBucketArcs(&state, frontier.items, frontier.size, 0);
+        }
+        free(state.buckets[b].items);
+        state.buckets[b].items = NULL;
+        state.buckets[b].capacity = 0;
+
+        relaxBucketArcs(&state, settled.items, settled.size, 1);
+    }
+
+    free(settled.items);
+    free(frontier.items);
+    free(settledStamp);
+    free(frontierStamp);
+    free(state.changed);
+    free(state.queued);
+    free(state.buckets);
+}
+
+// Write the vertices on the shortest path to target into path[] (source first)
+// and return their count, or 0 if target was not reached
+int shortestPath(int parent[], long long dist[], int target, int path[])
+{
+    if (dist[target] == INF_DISTANCE)
+    {
+        return 0;
+    }
+    int length = 0;
+    for (int v = target; v != -1; v = parent[v])
+    {
+        path[length++] = v;
+    }
+    for (int i = 0, j = length - 1; i < j; i++, j--)
+    {
+        int temp = path[i];
+        path[i] = path[j];
+        path[j] = temp;
+    }
+    return length;
+}
+
+// Dijkstra's Shortest Path
+void dijkstra(Graph *g, int start)
+{
+    int vertices = g->vertices;
+    long long *dist = (long long *)allocate(vertices * sizeof(long long));
+    int *parent = (int *)allocate(vertices * sizeof(int));
+    int *path = (int *)allocate(vertices * sizeof(int));
+
+    dijkstraHeap(g, internalVertex(g, start), dist, parent);
+
+    printf("Dijkstra's Shortest Path (from vertex %d):\n", start);
+    for (int i = 0; i < vertices; i++)
+    {
+        int target = internalVertex(g, i);
+        int length = shortestPath(parent, dist, target, path);
+        if (length == 0)
+        {
+            printf("Vertex %d: unreachable\n", i);
+            continue;
+        }
+        printf("Vertex %d: %lld (path:", i, dist[target]);
+        for (int j = 0; j < length; j++)
+        {
+            printf(" %d", originalVertex(g, path[j]));
+        }
+        printf(")\n");
+    }
+
+    free(path);
+    free(parent);
+    free(dist);
+}
+
+// Kruskal's Algorithm Helper Functions
+// Iterative find with path halving: every visited node skips to its grandparent
+int find(Subset subsets[], int i)
+{
+    while (subsets[i].parent != i)
+    {
+        subsets[i].parent = subsets[subsets[i].parent].parent;
+        i = subsets[i].parent;
+    }
+    return i;
+}
+
+void Union(Subset subsets[], int x, int y)
+{
+    int rootX = find(subsets, x);
+    int rootY = find(subsets, y);
+
+    if (subsets[rootX].rank < subsets[rootY].rank)
+    {
+        subsets[rootX].parent = rootY;
+    }
+    else if (subsets[rootX].rank > subsets[rootY].rank)
+    {
+        subsets[rootY].parent = rootX;
+    }
+    else
+    {
+        subsets[rootY].parent = rootX;
+        subsets[rootX].rank++;
+    }
+}
+
+// Disjoint sets that many threads can query and merge at once without a
+// lock. Roots are linked with a compare-and-swap, lower priority under
+// higher, where the priority is a fixed odd-multiplier permutation of the id
+// so every thread agrees on the direction and trees stay shallow. Finds
+// compress paths by halving, also with CAS.
+typedef struct ConcurrentDSU
+{
+    int *parent;
+    int size;
+} ConcurrentDSU;
+
+// Create size singleton sets
+ConcurrentDSU *createConcurrentDSU(int size)
+{
+    ConcurrentDSU *dsu = (ConcurrentDSU *)allocate(sizeof(ConcurrentDSU));
+    dsu->parent = (int *)allocate(size * sizeof(int));
+    dsu->size = size;
+    for (int i = 0; i < size; i++)
+    {
+        dsu->parent[i] = i;
+    }
+    return dsu;
+}
+
+void freeConcurrentDSU(ConcurrentDSU *dsu)
+{
+    free(dsu->parent);
+    free(dsu);
+}
+
+// Linking priority of a root; a bijection on 32-bit ids, so there are no ties
+uint32_t linkPriority(int x)
+{
+    return (uint32_t)x * 0x9E3779B1u;
+}
+
+// Current root of x's set; may be stale as soon as it returns if other
+// threads are linking
+int concurrentFind(ConcurrentDSU *dsu, int x)
+{
+    while (1)
+    {
+        int parent = __atomic_load_n(&dsu->parent[x], __ATOMIC_ACQUIRE);
+        if (parent == x)
+        {
+            return x;
+        }
+        int grandparent = __atomic_load_n(&dsu->parent[parent], __ATOMIC_ACQUIRE);
+        if (parent != grandparent)
+        {
+            __atomic_compare_exchange_n(&dsu->parent[x], &parent, grandparent, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+        }
+        x = grandparent;
+    }
+}
+
+// Check whether a and b are in the same set. A differing answer is only
+// returned once a is confirmed to still be a root.
+int concurrentSameSet(ConcurrentDSU *dsu, int a, int b)
+{
+    while (1)
+    {
+        a = concurrentFind(dsu, a);
+        b = concurrentFind(dsu, b);
+        if (a == b)
+        {
+            return 1;
+        }
+        if (__atomic_load_n(&dsu->parent[a], __ATOMIC_ACQUIRE) == a)
+        {
+            return 0;
+        }
+    }
+}
+
+// Merge the sets of a and b; returns 1 if this call linked two roots
+int concurrentUnion(ConcurrentDSU *dsu, int a, int b)
+{
+    while (1)
+    {
+        a = concurrentFind(dsu, a);
+        b = concurrentFind(dsu, b);
+        if (a == b)
+        {
+            return 0;
+        }
+        if (linkPriority(a) > linkPriority(b))
+        {
+            int temp = a;
+            a = b;
+            b = temp;
+        }
+        int expected = a;
+        if (__atomic_compare_exchange_n(&dsu->parent[a], &expected, b, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            return 1;
+        }
+    }
+}
+
+// Merge the endpoints of a batch of edges from any thread; the batch itself
+// is split across threads. Returns how many merges happened.
+long concurrentUnionEdges(ConcurrentDSU *dsu, const Edge edges[], long count)
+{
+    long merges = 0;
+#pragma omp parallel for schedule(static) reduction(+ : merges)
+    for (long i = 0; i < count; i++)
+    {
+        merges += concurrentUnion(dsu, edges[i].src, edges[i].dest);
+    }
+    return merges;
+}
+
+// Connected components (weakly connected for directed graphs) with the
+// concurrent union-find. Labels component[] with 0 .. count - 1 and returns
+// the count.
+int connectedComponents(Graph *g, int component[])
+{
+    int n = g->vertices;
+    ConcurrentDSU *dsu = createConcurrentDSU(n);
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for (int u = 0; u < n; u++)
+    {
+        for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+        {
+            if (g->directed || u < g->targets[e])
+            {
+                concurrentUnion(dsu, u, g->targets[e]);
+            }
+        }
+    }
+
+    int components = 0;
+    for (int v = 0; v < n; v++)
+    {
+        component[v] = -1;
+    }
+    for (int v = 0; v < n; v++)
+    {
+        int root = concurrentFind(dsu, v);
+        if (component[root] == -1)
+        {
+            component[root] = components++;
+        }
+        component[v] = component[root];
+    }
+
+    freeConcurrentDSU(dsu);
+    return components;
+}
+
+// Collect the edges of a graph; undirected edges are reported once (src < dest)
+long collectEdges(Graph *g, Edge edges[])
+{
+    long count = 0;
+    for (int u = 0; u < g->vertices; u++)
+    {
+        for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+        {
+            if (g->directed || u < g->targets[e])
+            {
+                edges[count].src = u;
+                edges[count].dest = g->targets[e];
+                edges[count].weight = g->weights[e];
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// Edge lists at most this long are sorted and scanned directly by Filter-Kruskal
+#define FILTER_KRUSKAL_THRESHOLD 1024
+
+// Edge lists shorter than this are sorted, partitioned and filtered by one
+// thread; below it a parallel region costs more than it saves
+#define PARALLEL_EDGE_MIN (1L << 16)
+
+// Radix sort key of a weight: flipping the sign bit orders negative weights
+// before non-negative ones
+unsigned int weightKey(int weight)
+{
+    return (unsigned int)weight ^ 0x80000000u;
+}
+
+// LSD radix sort of edges by weight, one byte per pass, in parallel for
+// long lists. Every thread histograms its own chunk, the histograms are
+// prefix-summed per digit and thread, and each thread scatters its chunk into
+// its reserved ranges. Passes whose digit is the same for every edge are
+// skipped. scratch must hold count edges.
+void radixSortEdges(Edge edges[], long count, Edge scratch[])
+{
+    int maxThreads = count >= PARALLEL_EDGE_MIN ? threadCount() : 1;
+    long *counts = (long *)allocate((size_t)maxThreads * 256 * sizeof(long));
+    Edge *src = edges, *dst = scratch;
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int skip = 0;
+#pragma omp parallel num_threads(maxThreads) if (maxThreads > 1)
+        {
+            int threads = activeThreads();
+            int t = threadId();
+            long begin = count * t / threads, end = count * (t + 1) / threads;
+            long *local = counts + (size_t)t * 256;
+
+            memset(local, 0, 256 * sizeof(long));
+            for (long i = begin; i < end; i++)
+            {
+                local[(weightKey(src[i].weight) >> shift) & 0xFF]++;
+            }
+#pragma omp barrier
+#pragma omp single
+            {
+                long offset = 0;
+                for (int d = 0; d < 256; d++)
+                {
+                    long digitTotal = 0;
+                    for (int k = 0; k < threads; k++)
+                    {
+                        long bucket = counts[(size_t)k * 256 + d];
+                        counts[(size_t)k * 256 + d] = offset;
+                        offset += bucket;
+                        digitTotal += bucket;
+                    }
+                    if (digitTotal == count)
+                    {
+                        skip = 1;
+                    }
+                }
+            }
+            if (!skip)
+            {
+                for (long i = begin; i < end; i++)
+                {
+                    dst[local[(weightKey(src[i].weight) >> shift) & 0xFF]++] = src[i];
+                }
+            }
+        }
+        if (!skip)
+        {
+            Edge *swap = src;
+            src = dst;
+            dst = swap;
+        }
+    }
+
+    if (src != edges)
+    {
+        memcpy(edges, src, count * sizeof(Edge));
+    }
+    free(counts);
+}
+
+// Running result of a minimum spanning forest computation
+typedef struct MstResult
+{
+    Edge *edges;
+    int count;
+    long long totalWeight;
+} MstResult;
+
+// Classic Kruskal step on a small edge list: sort it, then keep every edge
+// that joins two different components
+void kruskalScan(Edge edges[], long count, Edge scratch[], Subset subsets[], MstResult *result)
+{
+    radixSortEdges(edges, count, scratch);
+    for (long i = 0; i < count; i++)
+    {
+        int x = find(subsets, edges[i].src);
+        int y = find(subsets, edges[i].dest);
+        if (x != y)
+        {
+            Union(subsets, x, y);
+            result->edges[result->count++] = edges[i];
+            result->totalWeight += edges[i].weight;
+        }
+    }
+}
+
+// Median of the first, middle and last edge weights
+int medianWeight(Edge edges[], long count)
+{
+    int a = edges[0].weight, b = edges[count / 2].weight, c = edges[count - 1].weight;
+    if ((a <= b && b <= c) || (c <= b && b <= a))
+    {
+        return b;
+    }
+    if ((b <= a && a <= c) || (c <= a && a <= b))
+    {
+        return a;
+    }
+    return c;
+}
+
+// Root of an element without path compression, so threads may look roots
+// up concurrently while no union is running
+int findRoot(Subset subsets[], int i)
+{
+    while (subsets[i].parent != i)
+    {
+        i = subsets[i].parent;
+    }
+    return i;
+}
+
+// Pivot of a partition step: edges with weight <= pivot (< pivot when
+// strict) are light
+typedef struct WeightPivot
+{
+    int pivot;
+    int strict;
+} WeightPivot;
+
+int isLightEdge(const Edge *edge, const void *context)
+{
+    const WeightPivot *split = (const WeightPivot *)context;
+    return split->strict ? edge->weight < split->pivot : edge->weight <= split->pivot;
+}
+
+// Whether an edge still joins two components of the union-find in context
+int joinsComponents(const Edge *edge, const void *context)
+{
+    Subset *subsets = (Subset *)context;
+    return findRoot(subsets, edge->src) != findRoot(subsets, edge->dest);
+}
+
+// Move the edges passing test to the front and return how many there are.
+// Long lists are split in parallel: every thread counts the passing edges of
+// its chunk, and after a prefix sum scatters its chunk into scratch (which
+// must hold count edges) before copying its part back.
+long partitionEdges(Edge edges[], long count, Edge scratch[], int (*test)(const Edge *, const void *),
+                    const void *context)
+{
+    int maxThreads = count >= PARALLEL_EDGE_MIN ? threadCount() : 1;
+    if (maxThreads == 1)
+    {
+        long passed = 0;
+        for (long i = 0; i < count; i++)
+        {
+            if (test(&edges[i], context))
+            {
+                Edge temp = edges[passed];
+                edges[passed++] = edges[i];
+                edges[i] = temp;
+            }
+        }
+        return passed;
+    }
+
+    long *before = (long *)allocate(((size_t)maxThreads + 1) * sizeof(long));
+    long passed = 0;
+#pragma omp parallel num_threads(maxThreads)
+    {
+        int threads = activeThreads();
+        int t = threadId();
+        long begin = count * t / threads, end = count * (t + 1) / threads;
+        long local = 0;
+        for (long i = begin; i < end; i++)
+        {
+            local += test(&edges[i], context) != 0;
+        }
+        before[t + 1] = local;
+#pragma omp barrier
+#pragma omp single
+        {
+            before[0] = 0;
+            for (int k = 0; k < threads; k++)
+            {
+                before[k + 1] += before[k];
+            }
+            passed = before[threads];
+        }
+        long pass = before[t], fail = passed + begin - before[t];
+        for (long i = begin; i < end; i++)
+        {
+            if (test(&edges[i], context))
+            {
+                scratch[pass++] = edges[i];
+            }
+            else
+            {
+                scratch[fail++] = edges[i];
+            }
+        }
+#pragma omp barrier
+        memcpy(edges + begin, scratch + begin, (end - begin) * sizeof(Edge));
+    }
+    free(before);
+    return passed;
+}
+
+// Filter-Kruskal (Osipov, Sanders, Singler): split the edges around a pivot
+// weight, solve the light half first, then drop heavy edges whose endpoints
+// are already connected before recursing on what is left
+void filterKruskalRecurse(Edge edges[], long count, Edge scratch[], Subset subsets[], int vertices, MstResult *result)
+{
+    if (count <= FILTER_KRUSKAL_THRESHOLD)
+    {
+        kruskalScan(edges, count, scratch, subsets, result);
+        return;
+    }
+
+    WeightPivot split = {medianWeight(edges, count), 0};
+    long light = partitionEdges(edges, count, scratch, isLightEdge, &split);
+    if (light == count)
+    {
+        split.strict = 1;
+        light = partitionEdges(edges, count, scratch, isLightEdge, &split);
+    }
+    if (light == 0)
+    {
+        kruskalScan(edges, count, scratch, subsets, result); // All weights equal
+        return;
+    }
+
+    filterKruskalRecurse(edges, light, scratch, subsets, vertices, result);
+    if (result->count == vertices - 1)
+    {
+        return;
+    }
+
+    Edge *heavy = edges + light;
+    long kept = partitionEdges(heavy, count - light, scratch, joinsComponents, subsets);
+    filterKruskalRecurse(heavy, kept, scratch, subsets, vertices, result);
+}
+
+// Minimum spanning forest of an undirected graph with Filter-Kruskal. The
+// edges are written to mst[] (room for vertices - 1 entries) in ascending
+// weight order; returns how many there are and stores their total weight.
+int filterKruskal(Graph *g, Edge mst[], long long *totalWeight)
+{
+    int vertices = g->vertices;
+    Edge *edges = (Edge *)allocate(g->arcs * sizeof(Edge));
+    Edge *scratch = (Edge *)allocate(g->arcs * sizeof(Edge));
+    long edgeCount = collectEdges(g, edges);
+
+    Subset *subsets = (Subset *)allocate(vertices * sizeof(Subset));
+    for (int i = 0; i < vertices; i++)
+    {
+        subsets[i].parent = i;
+        subsets[i].rank = 0;
+    }
+
+    MstResult result = {mst, 0, 0};
+    filterKruskalRecurse(edges, edgeCount, scratch, subsets, vertices, &result);
+    *totalWeight = result.totalWeight;
+
+    free(subsets);
+    free(scratch);
+    free(edges);
+    return result.count;
+}
+
+// Print a spanning forest using the caller's vertex ids
+void printSpanningTree(Graph *g, const char *title, Edge mst[], int count, long long totalWeight)
+{
+    printf("%s:\n", title);
+    for (int i = 0; i < count; i++)
+    {
+        printf("Edge (%d, %d) with weight %d\n", originalVertex(g, mst[i].src), originalVertex(g, mst[i].dest), mst[i].weight);
+    }
+    printf("Total weight: %lld\n", totalWeight);
+}
+
+// Kruskal's Algorithm
+void kruskal(Graph *g)
+{
+    Edge *mst = (Edge *)allocate(g->vertices * sizeof(Edge));
+    long long totalWeight;
+    int count = filterKruskal(g, mst, &totalWeight);
+    printSpanningTree(g, "Kruskal's Minimum Spanning Tree", mst, count, totalWeight);
+    free(mst);
+}
+
+// Boruvka order between two edges of the same list: by weight, ties broken
+// by position so every component agrees on a single minimum
+int lighterEdge(const Edge edges[], long a, long b)
+{
+    return edges[a].weight < edges[b].weight || (edges[a].weight == edges[b].weight && a < b);
+}
+
+// Parallel Boruvka minimum spanning forest of an undirected graph. Each round
+// every component picks its lightest outgoing edge in parallel (CAS on a
+// per-root candidate), the picked edges are contracted through the
+// concurrent union-find, and edges that became internal are dropped. Writes
+// the forest to mst[] (room for vertices - 1 edges), returns its size and
+// stores its total weight.
+int boruvka(Graph *g, Edge mst[], long long *totalWeight)
+{
+    int n = g->vertices;
+    Edge *edges = (Edge *)allocate(g->arcs * sizeof(Edge));
+    long edgeCount = collectEdges(g, edges);
+    long *best = (long *)allocate(n * sizeof(long));
+    ConcurrentDSU *dsu = createConcurrentDSU(n);
+    int count = 0;
+    long long total = 0;
+
+    for (int v = 0; v < n; v++)
+    {
+        best[v] = -1;
+    }
+
+    while (edgeCount > 0)
+    {
+#pragma omp parallel for schedule(static)
+        for (long i = 0; i < edgeCount; i++)
+        {
+            int roots[2] = {concurrentFind(dsu, edges[i].src), concurrentFind(dsu, edges[i].dest)};
+            if (roots[0] == roots[1])
+            {
+                continue;
+            }
+            for (int k = 0; k < 2; k++)
+            {
+                long current = __atomic_load_n(&best[roots[k]], __ATOMIC_RELAXED);
+                while ((current == -1 || lighterEdge(edges, i, current)) &&
+                       !__atomic_compare_exchange_n(&best[roots[k]], &current, i, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                {
+                }
+            }
+        }
+
+        int merged = 0;
+#pragma omp parallel for schedule(static) reduction(+ : merged, total)
+        for (int v = 0; v < n; v++)
+        {
+            long e = best[v];
+            if (e == -1)
+            {
+                continue;
+            }
+            best[v] = -1;
+            if (concurrentUnion(dsu, edges[e].src, edges[e].dest))
+            {
+                mst[__atomic_fetch_add(&count, 1, __ATOMIC_RELAXED)] = edges[e];
+                total += edges[e].weight;
+                merged++;
+            }
+        }
+        if (merged == 0)
+        {
+            break;
+        }
+
+        long kept = 0;
+        for (long i = 0; i < edgeCount; i++)
+        {
+            if (concurrentFind(dsu, edges[i].src) != concurrentFind(dsu, edges[i].dest))
+            {
+                edges[kept++] = edges[i];
+            }
+        }
+        edgeCount = kept;
+    }
+
+    freeConcurrentDSU(dsu);
+    free(best);
+    free(edges);
+    *totalWeight = total;
+    return count;
+}
+
+// Prim's minimum spanning forest with the lazy d-ary heap, suited to dense
+// graphs. Same output contract as boruvka; edges are listed in the order they
+// join the tree.
+int prim(Graph *g, Edge mst[], long long *totalWeight)
+{
+    int n = g->vertices;
+    char *inTree = (char *)allocateZeroed(n, sizeof(char));
+    long long *bestWeight = (long long *)allocate(n * sizeof(long long));
+    int *bestFrom = (int *)allocate(n * sizeof(int));
+    DaryHeap heap = {NULL, 0, 0};
+    int count = 0;
+    long long total = 0;
+
+    for (int v = 0; v < n; v++)
+    {
+        bestWeight[v] = INF_DISTANCE;
+        bestFrom[v] = -1;
+    }
+
+    for (int root = 0; root < n; root++)
+    {
+        if (inTree[root])
+        {
+            continue;
+        }
+        bestWeight[root] = LLONG_MIN;
+        heapPush(&heap, LLONG_MIN, root);
+        while (heap.size > 0)
+        {
+            HeapEntry top = heapPop(&heap);
+            int u = top.vertex;
+            if (inTree[u] || top.key != bestWeight[u])
+            {
+                continue;
+            }
+            inTree[u] = 1;
+            if (bestFrom[u] != -1)
+            {
+                Edge edge = {bestFrom[u], u, (int)top.key};
+                mst[count++] = edge;
+                total += top.key;
+            }
+            for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+            {
+                int v = g->targets[e];
+                if (!inTree[v] && g->weights[e] < bestWeight[v])
+                {
+                    bestWeight[v] = g->weights[e];
+                    bestFrom[v] = u;
+                    heapPush(&heap, g->weights[e], v);
+                }
+            }
+        }
+    }
+
+    free(heap.entries);
+    free(bestFrom);
+    free(bestWeight);
+    free(inTree);
+    *totalWeight = total;
+    return count;
+}
+
+// Arc stored in a dynamic graph's adjacency array
+typedef struct DynamicArc
+{
+    int target;
+    int weight;
+} DynamicArc;
+
+// Growable adjacency array of one vertex
+typedef struct ArcList
+{
+    DynamicArc *arcs;
+    int size;
+    int capacity;
+} ArcList;
+
+// Mutable graph with one adjacency array per vertex and at most one arc per
+// ordered vertex pair. Directed graphs also keep in-arcs; for undirected
+// graphs in == out.
+typedef struct DynamicGraph
+{
+    int vertices;
+    int directed;
+    ArcList *out;
+    ArcList *in;
+} DynamicGraph;
+
+// Kinds of edge updates in a batch
+typedef enum UpdateKind
+{
+    EDGE_INSERT, // Add the edge, or overwrite its weight if it exists
+    EDGE_DELETE, // Remove the edge if it exists
+    EDGE_UPDATE  // Change the weight of an existing edge
+} UpdateKind;
+
+typedef struct EdgeUpdate
+{
+    UpdateKind kind;
+    int src, dest, weight;
+} EdgeUpdate;
+
+// Create an empty dynamic graph
+DynamicGraph *createDynamicGraph(int vertices, int directed)
+{
+    DynamicGraph *g = (DynamicGraph *)allocate(sizeof(DynamicGraph));
+    g->vertices = vertices;
+    g->directed = directed;
+    g->out = (ArcList *)allocateZeroed(vertices, sizeof(ArcList));
+    g->in = directed ? (ArcList *)allocateZeroed(vertices, sizeof(ArcList)) : g->out;
+    return g;
+}
+
+void freeDynamicGraph(DynamicGraph *g)
+{
+    for (int v = 0; v < g->vertices; v++)
+    {
+        free(g->out[v].arcs);
+        if (g->directed)
+        {
+            free(g->in[v].arcs);
+        }
+    }
+    if (g->directed)
+    {
+        free(g->in);
+    }
+    free(g->out);
+    free(g);
+}
+
+// Set the weight of the arc to target, adding it if needed. Returns the old
+// weight, or INT_MIN if the arc is new.
+int setArc(ArcList *list, int target, int weight)
+{
+    for (int i = 0; i < list->size; i++)
+    {
+        if (list->arcs[i].target == target)
+        {
+            int old = list->arcs[i].weight;
+            list->arcs[i].weight = weight;
+            return old;
+        }
+    }
+    if (list->size == list->capacity)
+    {
+        list->capacity = list->capacity > 0 ? list->capacity * 2 : 4;
+        DynamicArc *grown = (DynamicArc *)realloc(list->arcs, list->capacity * sizeof(DynamicArc));
+        if (grown == NULL)
+        {
+            printf("Memory allocation failed.\n");
+            exit(1);
+        }
+        list->arcs = grown;
+    }
+    list->arcs[list->size].target = target;
+    list->arcs[list->size].weight = weight;
+    list->size++;
+    return INT_MIN;
+}
+
+// Weight of the arc to target, or INT_MIN if there is none
+int arcWeight(ArcList *list, int target)
+{
+    for (int i = 0; i < list->size; i++)
+    {
+        if (list->arcs[i].target == target)
+        {
+            return list->arcs[i].weight;
+        }
+    }
+    return INT_MIN;
+}
+
+// Remove the arc to target by moving the last arc into its slot. Returns the
+// removed weight, or INT_MIN if there was no such arc.
+int removeArc(ArcList *list, int target)
+{
+    for (int i = 0; i < list->size; i++)
+    {
+        if (list->arcs[i].target == target)
+        {
+            int old = list->arcs[i].weight;
+            list->arcs[i] = list->arcs[--list->size];
+            return old;
+        }
+    }
+    return INT_MIN;
+}
+
+// Apply one update; returns the edge's previous weight (INT_MIN if absent)
+int applyUpdate(DynamicGraph *g, const EdgeUpdate *update)
+{
+    int u = update->src, v = update->dest;
+    int old = arcWeight(&g->out[u], v);
+    if (update->kind == EDGE_DELETE || (update->kind == EDGE_UPDATE && old == INT_MIN))
+    {
+        if (old != INT_MIN)
+        {
+            removeArc(&g->out[u], v);
+            removeArc(&g->in[v], u);
+        }
+        return old;
+    }
+    setArc(&g->out[u], v, update->weight);
+    if (u != v || g->directed)
+    {
+        setArc(&g->in[v], u, update->weight);
+    }
+    return old;
+}
+
+// Apply a batch of updates without maintaining any derived data
+void applyUpdates(DynamicGraph *g, const EdgeUpdate updates[], int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        applyUpdate(g, &updates[i]);
+    }
+}
+
+// Dynamic copy of a CSR graph (parallel edges keep the last weight)
+DynamicGraph *createDynamicGraphFrom(Graph *g)
+{
+    DynamicGraph *d = createDynamicGraph(g->vertices, g->directed);
+    for (int u = 0; u < g->vertices; u++)
+    {
+        for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+        {
+            int v = g->targets[e];
+            if (g->directed || u <= v)
+            {
+                EdgeUpdate update = {EDGE_INSERT, u, v, g->weights[e]};
+                applyUpdate(d, &update);
+            }
+        }
+    }
+    return d;
+}
+
+// Shortest-path tree from one source, kept current across update batches
+typedef struct IncrementalSssp
+{
+    DynamicGraph *g;
+    int source;
+    long long *dist;
+    int *parent;
+} IncrementalSssp;
+
+// Run lazy-heap Dijkstra from whatever vertices are already in the heap
+void propagateDistances(IncrementalSssp *sp, DaryHeap *heap)
+{
+    while (heap->size > 0)
+    {
+        HeapEntry top = heapPop(heap);
+        int u = top.vertex;
+        if (top.key != sp->dist[u])
+        {
+            continue;
+        }
+        ArcList *list = &sp->g->out[u];
+        for (int i = 0; i < list->size; i++)
+        {
+            int v = list->arcs[i].target;
+            long long candidate = sp->dist[u] + list->arcs[i].weight;
+            if (candidate < sp->dist[v])
+            {
+                sp->dist[v] = candidate;
+                sp->parent[v] = u;
+                heapPush(heap, candidate, v);
+            }
+        }
+    }
+}
+
+// Compute shortest paths from source on a dynamic graph with non-negative
+// weights; keep the result current with updateIncrementalSssp
+IncrementalSssp *createIncrementalSssp(DynamicGraph *g, int source)
+{
+    IncrementalSssp *sp = (IncrementalSssp *)allocate(sizeof(IncrementalSssp));
+    sp->g = g;
+    sp->source = source;
+    sp->dist = (long long *)allocate(g->vertices * sizeof(long long));
+    sp->parent = (int *)allocate(g->vertices * sizeof(int));
+    for (int v = 0; v < g->vertices; v++)
+    {
+        sp->dist[v] = INF_DISTANCE;
+        sp->parent[v] = -1;
+    }
+    sp->dist[source] = 0;
+
+    DaryHeap heap = {NULL, 0, 0};
+    heapPush(&heap, 0, source);
+    propagateDistances(sp, &heap);
+    free(heap.entries);
+    return sp;
+}
+
+void freeIncrementalSssp(IncrementalSssp *sp)
+{
+    free(sp->parent);
+    free(sp->dist);
+    free(sp);
+}
+
+// Note that arc u -> v changed from oldWeight: a tree arc that got heavier or
+// vanished invalidates v's subtree (v is listed once, marked in affected), an
+// arc that now gives a shorter path seeds the repair heap
+void noteArcChange(IncrementalSssp *sp, int u, int v, int oldWeight, int newWeight, VertexList *invalid,
+                   char affected[], DaryHeap *heap)
+{
+    int removed = newWeight == INT_MIN;
+    if (sp->parent[v] == u && oldWeight != INT_MIN && (removed || newWeight > oldWeight))
+    {
+        if (!affected[v])
+        {
+            affected[v] = 1;
+            appendVertex(invalid, v);
+        }
+    }
+    else if (!removed && sp->dist[u] != INF_DISTANCE && sp->dist[u] + newWeight < sp->dist[v])
+    {
+        sp->dist[v] = sp->dist[u] + newWeight;
+        sp->parent[v] = u;
+        heapPush(heap, sp->dist[v], v);
+    }
+}
+
+// Apply a batch of updates and repair only the affected part of the
+// shortest-path tree. Subtrees hanging off tree arcs that were deleted or
+// made heavier are reset and re-seeded from their unaffected in-neighbors;
+// arcs that got lighter or appeared seed the heap directly; one Dijkstra pass
+// from those seeds then settles everything. Returns the number of vertices
+// whose distance had to be recomputed from scratch.
+int updateIncrementalSssp(IncrementalSssp *sp, const EdgeUpdate updates[], int count)
+{
+    DynamicGraph *g = sp->g;
+    VertexList invalid = {NULL, 0, 0};
+    DaryHeap heap = {NULL, 0, 0};
+    char *affected = (char *)allocateZeroed(g->vertices, sizeof(char));
+
+    for (int i = 0; i < count; i++)
+    {
+        int u = updates[i].src, v = updates[i].dest;
+        int old = applyUpdate(g, &updates[i]);
+        int now = arcWeight(&g->out[u], v);
+        noteArcChange(sp, u, v, old, now, &invalid, affected, &heap);
+        if (!g->directed && u != v)
+        {
+            noteArcChange(sp, v, u, old, now, &invalid, affected, &heap);
+        }
+    }
+
+    // Reset every vertex below an invalidated tree arc
+    for (long i = 0; i < invalid.size; i++)
+    {
+        int u = invalid.items[i];
+        ArcList *list = &g->out[u];
+        for (int k = 0; k < list->size; k++)
+        {
+            int child = list->arcs[k].target;
+            if (!affected[child] && sp->parent[child] == u)
+            {
+                affected[child] = 1;
+                appendVertex(&invalid, child);
+            }
+        }
+    }
+    for (long i = 0; i < invalid.size; i++)
+    {
+        sp->dist[invalid.items[i]] = INF_DISTANCE;
+        sp->parent[invalid.items[i]] = -1;
+    }
+
+    // Re-seed the reset vertices from neighbors that kept their distance
+    for (long i = 0; i < invalid.size; i++)
+    {
+        int v = invalid.items[i];
+        ArcList *list = &g->in[v];
+        for (int k = 0; k < list->size; k++)
+        {
+            int u = list->arcs[k].target;
+            if (!affected[u] && sp->dist[u] != INF_DISTANCE && sp->dist[u] + list->arcs[k].weight < sp->dist[v])
+            {
+                sp->dist[v] = sp->dist[u] + list->arcs[k].weight;
+                sp->parent[v] = u;
+            }
+        }
+        if (sp->dist[v] != INF_DISTANCE)
+        {
+            heapPush(&heap, sp->dist[v], v);
+        }
+    }
+
+    propagateDistances(sp, &heap);
+
+    int recomputed = (int)invalid.size;
+    free(affected);
+    free(heap.entries);
+    free(invalid.items);
+    return recomputed;
+}
+
+// Vertex orderings available to reorderGraph
+typedef enum VertexOrdering
+{
+    ORDER_RCM,    // Reverse Cuthill-McKee: small bandwidth, neighbors stay close
+    ORDER_DEGREE, // Highest degree first, so hub data shares cache lines
+    ORDER_BFS     // Breadth-first discovery order
+} VertexOrdering;
+
+int compareKeys(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Sort vertices by degree (ascending, or descending when requested), ties by
+// id, packing each (degree, vertex) pair into one 64-bit key
+void sortByDegree(Graph *g, int vertices[], long count, int descending, uint64_t keys[])
+{
+    for (long i = 0; i < count; i++)
+    {
+        uint64_t d = (uint64_t)degree(g, vertices[i]);
+        keys[i] = ((descending ? UINT32_MAX - d : d) << 32) | (uint32_t)vertices[i];
+    }
+    qsort(keys, count, sizeof(uint64_t), compareKeys);
+    for (long i = 0; i < count; i++)
+    {
+        vertices[i] = (int)(keys[i] & UINT32_MAX);
+    }
+}
+
+// Compute order[newId] = oldId for the requested ordering. Breadth-first
+// orderings start every component from its lowest-degree (RCM) or
+// lowest-numbered (BFS) vertex.
+int *computeOrdering(Graph *g, VertexOrdering ordering)
+{
+    int n = g->vertices;
+    int *order = (int *)allocate(n * sizeof(int));
+    uint64_t *keys = (uint64_t *)allocate(n * sizeof(uint64_t));
+    for (int v = 0; v < n; v++)
+    {
+        order[v] = v;
+    }
+
+    if (ordering == ORDER_DEGREE)
+    {
+        sortByDegree(g, order, n, 1, keys);
+        free(keys);
+        return order;
+    }
+
+    int *seeds = (int *)allocate(n * sizeof(int));
+    memcpy(seeds, order, n * sizeof(int));
+    if (ordering == ORDER_RCM)
+    {
+        sortByDegree(g, seeds, n, 0, keys);
+    }
+
+    char *visited = (char *)allocateZeroed(n, sizeof(char));
+    int *neighbors = (int *)allocate(n * sizeof(int));
+    long front = 0, rear = 0;
+    for (int s = 0; s < n; s++)
+    {
+        if (visited[seeds[s]])
+        {
+            continue;
+        }
+        visited[seeds[s]] = 1;
+        order[rear++] = seeds[s];
+        while (front < rear)
+        {
+            int u = order[front++];
+            long found = 0;
+            for (long e = g->offsets[u]; e < g->offsets[u + 1]; e++)
+            {
+                int v = g->targets[e];
+                if (!visited[v])
+                {
+                    visited[v] = 1;
+                    neighbors[found++] = v;
+                }
+            }
+            if (ordering == ORDER_RCM)
+            {
+                sortByDegree(g, neighbors, found, 0, keys);
+            }
+            memcpy(order + rear, neighbors, found * sizeof(int));
+            rear += found;
+        }
+    }
+
+    if (ordering == ORDER_RCM)
+    {
+        for (int i = 0, j = n - 1; i < j; i++, j--)
+        {
+            int temp = order[i];
+            order[i] = order[j];
+            order[j] = temp;
+        }
+    }
+
+    free(neighbors);
+    free(visited);
+    free(seeds);
+    free(keys);
+    return order;
+}
+
+// Copy of a graph with its vertices relabeled by the given ordering for better
+// cache and TLB locality. The new graph remembers the permutation: the
+// printing traversals take and print the caller's ids, and results of the
+// other algorithms (which use internal ids) map back with
+// internalVertex/originalVertex and restoreDistances/restoreParents.
+Graph *reorderGraph(Graph *g, VertexOrdering ordering)
+{
+    int n = g->vertices;
+    int *order = computeOrdering(g, ordering);
+    int *newId = (int *)allocate(n * sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        newId[order[i]] = i;
+    }
+
+    Graph *r = (Graph *)allocate(sizeof(Graph));
+    r->vertices = n;
+    r->directed = g->directed;
+    r->arcs = g->arcs;
+    r->mapping = NULL;
+    r->mappingSize = 0;
+    r->offsets = (long *)allocate((n + 1) * sizeof(long));
+    r->targets = (int *)allocate(g->arcs * sizeof(int));
+    r->weights = (int *)allocate(g->arcs * sizeof(int));
+
+    r->offsets[0] = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int old = order[i];
+        long out = r->offsets[i];
+        for (long e = g->offsets[old]; e < g->offsets[old + 1]; e++, out++)
+        {
+            r->targets[out] = newId[g->targets[e]];
+            r->weights[out] = g->weights[e];
+        }
+        r->offsets[i + 1] = out;
+    }
+
+    // Compose with an earlier relabeling so ids always refer to the caller's
+    r->originalIds = order;
+    r->internalIds = newId;
+    for (int i = 0; i < n; i++)
+    {
+        r->originalIds[i] = originalVertex(g, order[i]);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        r->internalIds[r->originalIds[i]] = i;
+    }
+    return r;
+}
+
+// Reindex a per-vertex distance array from internal to original ids
+void restoreDistances(Graph *g, const long long internal[], long long original[])
+{
+    for (int v = 0; v < g->vertices; v++)
+    {
+        original[originalVertex(g, v)] = internal[v];
+    }
+}
+
+// Reindex a parent array from internal to original ids, translating the
+// parent ids themselves as well (-1 stays -1)
+void restoreParents(Graph *g, const int internal[], int original[])
+{
+    for (int v = 0; v < g->vertices; v++)
+    {
+        original[originalVertex(g, v)] = internal[v] >= 0 ? originalVertex(g, internal[v]) : -1;
+    }
+}
+
+// Largest edge weight produced by the graph generators
+#define GENERATOR_MAX_WEIGHT 100
+
+// Average number of edges per vertex in R-MAT and Erdos-Renyi graphs
+#define GENERATOR_EDGE_FACTOR 16
+
+// splitmix64 step, so every generated graph is reproducible from its seed
+uint64_t nextRandom(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform random edge weight in 1 .. GENERATOR_MAX_WEIGHT
+int randomWeight(uint64_t *state)
+{
+    return (int)(nextRandom(state) % GENERATOR_MAX_WEIGHT) + 1;
+}
+
+// R-MAT / Kronecker graph with 2^scale vertices and the Graph500 quadrant
+// probabilities (0.57, 0.19, 0.19, 0.05)
+Edge *generateRmat(int scale, uint64_t seed, long *edgeCount)
+{
+    long count = (long)GENERATOR_EDGE_FACTOR << scale;
+    Edge *edges = (Edge *)allocate(count * sizeof(Edge));
+    uint64_t state = seed;
+
+    for (long i = 0; i < count; i++)
+    {
+        int src = 0, dest = 0;
+        for (int bit = 0; bit < scale; bit++)
+        {
+            double r = (double)(nextRandom(&state) >> 11) / 9007199254740992.0;
+            if (r >= 0.57)
+            {
+                if (r < 0.76)
+                {
+                    dest |= 1 << bit;
+                }
+                else if (r < 0.95)
+                {
+                    src |= 1 << bit;
+                }
+                else
+                {
+                    src |= 1 << bit;
+                    dest |= 1 << bit;
+                }
+            }
+        }
+        edges[i].src = src;
+        edges[i].dest = dest;
+        edges[i].weight = randomWeight(&state);
+    }
+    *edgeCount = count;
+    return edges;
+}
+
+// Two-dimensional grid with 2^scale vertices and 4-neighbor connectivity
+Edge *generateGrid(int scale, uint64_t seed, long *edgeCount)
+{
+    int rows = 1 << (scale / 2), cols = 1 << (scale - scale / 2);
+    Edge *edges = (Edge *)allocate(2 * (long)rows * cols * sizeof(Edge));
+    uint64_t state = seed;
+    long count = 0;
+
+    for (int r = 0; r < rows; r++)
+    {
+        for (int c = 0; c < cols; c++)
+        {
+            int v = r * cols + c;
+            if (c + 1 < cols)
+            {
+                Edge edge = {v, v + 1, randomWeight(&state)};
+                edges[count++] = edge;
+            }
+            if (r + 1 < rows)
+            {
+                Edge edge = {v, v + cols, randomWeight(&state)};
+                edges[count++] = edge;
+            }
+        }
+    }
+    *edgeCount = count;
+    return edges;
+}
+
+// Erdos-Renyi G(n, m) graph with 2^scale vertices and uniformly random edges
+Edge *generateErdosRenyi(int scale, uint64_t seed, long *edgeCount)
+{
+    int vertices = 1 << scale;
+    long count = (long)GENERATOR_EDGE_FACTOR << scale;
+    Edge *edges = (Edge *)allocate(count * sizeof(Edge));
+    uint64_t state = seed;
+
+    for (long i = 0; i < count; i++)
+    {
+        edges[i].src = (int)(nextRandom(&state) % vertices);
+        edges[i].dest = (int)(nextRandom(&state) % vertices);
+        edges[i].weight = randomWeight(&state);
+    }
+    *edgeCount = count;
+    return edges;
+}
+
+// Inputs, outputs and work counter shared by the benchmark kernels
+typedef struct BenchmarkContext
+{
+    Graph *g;
+    int source;
+    long long *dist;
+    int *parent;
+    int *level;
+    char *color;
+    DfsFrame *frames;
+    Edge *mst;
+    long edgesTraversed; // Arcs examined by the last run, for TEPS
+} BenchmarkContext;
+
+typedef void (*BenchmarkKernel)(BenchmarkContext *context);
+
+// Sum of the out-degrees of the vertices a traversal reached
+long reachedArcs(Graph *g, const long long dist[])
+{
+    long arcs = 0;
+    for (int v = 0; v < g->vertices; v++)
+    {
+        if (dist[v] != INF_DISTANCE)
+        {
+            arcs += degree(g, v);
+        }
+    }
+    return arcs;
+}
+
+void benchBfs(BenchmarkContext *context)
+{
+    Graph *g = context->g;
+    bfsDirectionOptimizing(g, originalVertex(g, context->source), context->parent, context->level);
+    for (int v = 0; v < g->vertices; v++)
+    {
+        context->dist[internalVertex(g, v)] = context->level[v] >= 0 ? context->level[v] : INF_DISTANCE;
+    }
+    context->edgesTraversed = reachedArcs(context->g, context->dist);
+}
+
+void benchDfs(BenchmarkContext *context)
+{
+    DfsVisitor visitor = {NULL, NULL, NULL, NULL};
+    memset(context->color, WHITE, context->g->vertices);
+    dfsVisit(context->g, context->source, context->color, context->frames, &visitor);
+    context->edgesTraversed = 0;
+    for (int v = 0; v < context->g->vertices; v++)
+    {
+        if (context->color[v] != WHITE)
+        {
+            context->edgesTraversed += degree(context->g, v);
+        }
+    }
+}
+
+void benchDijkstraHeap(BenchmarkContext *context)
+{
+    dijkstraHeap(context->g, context->source, context->dist, context->parent);
+    context->edgesTraversed = reachedArcs(context->g, context->dist);
+}
+
+void benchDijkstraRadix(BenchmarkContext *context)
+{
+    dijkstraRadix(context->g, context->source, context->dist, context->parent);
+    context->edgesTraversed = reachedArcs(context->g, context->dist);
+}
+
+void benchDeltaStepping(BenchmarkContext *context)
+{
+    deltaStepping(context->g, context->source, 0, context->dist);
+    context->edgesTraversed = reachedArcs(context->g, context->dist);
+}
+
+void benchKruskal(BenchmarkContext *context)
+{
+    long long totalWeight;
+    filterKruskal(context->g, context->mst, &totalWeight);
+    context->edgesTraversed = context->g->arcs;
+}
+
+void benchBoruvka(BenchmarkContext *context)
+{
+    long long totalWeight;
+    boruvka(context->g, context->mst, &totalWeight);
+    context->edgesTraversed = context->g->arcs;
+}
+
+void benchPrim(BenchmarkContext *context)
+{
+    long long totalWeight;
+    prim(context->g, context->mst, &totalWeight);
+    context->edgesTraversed = context->g->arcs;
+}
+
+void benchComponents(BenchmarkContext *context)
+{
+    connectedComponents(context->g, context->parent);
+    context->edgesTraversed = context->g->arcs;
+}
+
+// Seconds on the monotonic clock
+double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Run a kernel warmup + repetitions times and print one JSON line with the
+// timings, traversed edges per second (from the median) and peak RSS
+void runBenchmark(const char *algorithm, BenchmarkKernel kernel, BenchmarkContext *context,
+                  const char *graphName, const char *orderName, int scale, int warmup, int repetitions)
+{
+    double *times = (double *)allocate(repetitions * sizeof(double));
+    for (int i = 0; i < warmup; i++)
+    {
+        kernel(context);
+    }
+    double total = 0;
+    for (int i = 0; i < repetitions; i++)
+    {
+        double start = nowSeconds();
+        kernel(context);
+        times[i] = nowSeconds() - start;
+        total += times[i];
+    }
+    qsort(times, repetitions, sizeof(double), compareDoubles);
+    double median = times[repetitions / 2];
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("{\"algorithm\": \"%s\", \"graph\": \"%s\", \"ordering\": \"%s\", \"scale\": %d, \"vertices\": %d, \"arcs\": %ld, "
+           "\"threads\": %d, \"repetitions\": %d, \"min_s\": %.6f, \"median_s\": %.6f, \"mean_s\": %.6f, "
+           "\"edges_traversed\": %ld, \"teps\": %.0f, \"peak_rss_kb\": %ld}\n",
+           algorithm, graphName, orderName, scale, context->g->vertices, context->g->arcs, threadCount(), repetitions,
+           times[0], median, total / repetitions, context->edgesTraversed,
+           median > 0 ? context->edgesTraversed / median : 0.0, usage.ru_maxrss);
+    fflush(stdout);
+    free(times);
+}
+
+// Generate a graph, optionally reorder it (none, rcm, degree or bfs) and
+// benchmark every algorithm on it; returns 0 on success
+int benchmarkGraphs(const char *graphName, int scale, int repetitions, int warmup, uint64_t seed,
+                    const char *orderName)
+{
+    long edgeCount;
+    Edge *edges;
+    if (scale < 1 || scale > 30 || repetitions < 1 || warmup < 0)
+    {
+        printf("Scale must be in 1..30, repetitions positive and warmup non-negative.\n");
+        return 1;
+    }
+    if (strcmp(graphName, "rmat") == 0)
+    {
+        edges = generateRmat(scale, seed, &edgeCount);
+    }
+    else if (strcmp(graphName, "grid") == 0)
+    {
+        edges = generateGrid(scale, seed, &edgeCount);
+    }
+    else if (strcmp(graphName, "er") == 0)
+    {
+        edges = generateErdosRenyi(scale, seed, &edgeCount);
+    }
+    else
+    {
+        printf("Unknown graph type %s (expected rmat, grid or er).\n", graphName);
+        return 1;
+    }
+
+    int vertices = 1 << scale;
+    BenchmarkContext context;
+    context.g = buildGraph(edges, edgeCount, vertices, 0);
+    free(edges);
+    if (strcmp(orderName, "none") != 0)
+    {
+        VertexOrdering ordering;
+        if (strcmp(orderName, "rcm") == 0)
+        {
+            ordering = ORDER_RCM;
+        }
+        else if (strcmp(orderName, "degree") == 0)
+        {
+            ordering = ORDER_DEGREE;
+        }
+        else if (strcmp(orderName, "bfs") == 0)
+        {
+            ordering = ORDER_BFS;
+        }
+        else
+        {
+            printf("Unknown ordering %s (expected none, rcm, degree or bfs).\n", orderName);
+            freeGraph(context.g);
+            return 1;
+        }
+        Graph *reordered = reorderGraph(context.g, ordering);
+        freeGraph(context.g);
+        context.g = reordered;
+    }
+    context.dist = (long long *)allocate(vertices * sizeof(long long));
+    context.parent = (int *)allocate(vertices * sizeof(int));
+    context.level = (int *)allocate(vertices * sizeof(int));
+    context.color = (char *)allocate(vertices * sizeof(char));
+    context.frames = (DfsFrame *)allocate(vertices * sizeof(DfsFrame));
+    context.mst = (Edge *)allocate(vertices * sizeof(Edge));
+    context.edgesTraversed = 0;
+
+    // Start from a reproducible vertex that has at least one neighbor
+    uint64_t state = seed;
+    do
+    {
+        context.source = internalVertex(context.g, (int)(nextRandom(&state) % vertices));
+    } while (degree(context.g, context.source) == 0 && context.g->arcs > 0);
+
+    runBenchmark("bfs", benchBfs, &context, graphName, orderName, scale, warmup, repetitions);
+    runBenchmark("dfs", benchDfs, &context, graphName, orderName, scale, warmup, repetitions);
+    runBenchmark("dijkstra_heap", benchDijkstraHeap, &context, graphName, orderName, scale, warmup, repetitions);
+    runBenchmark("dijkstra_radix", benchDijkstraRadix, &context, graphName, orderName, scale, warmup, repetitions);
+    runBenchmark("delta_stepping", benchDeltaStepping, &context, graphName, orderName, scale, warmup, repetitions);
+    runBenchmark("kruskal", benchKruskal, &context, graphName, orderName, scale, warmup, repetitions);
+    runBenchmark("boruvka", benchBoruvka, &context, graphName, orderName, scale, warmup, repetitions);
+    runBenchmark("prim", benchPrim, &context, graphName, orderName, scale, warmup, repetitions);
+    runBenchmark("components", benchComponents, &context, graphName, orderName, scale, warmup, repetitions);
+
+    free(context.mst);
+    free(context.frames);
+    free(context.color);
+    free(context.level);
+    free(context.parent);
+    free(context.dist);
+    freeGraph(context.g);
+    return 0;
+}
+
+// Main Function
+int main(int argc, char *argv[])
+{
+    int convert = argc >= 2 && strcmp(argv[1], "convert") == 0;
+    int bench = argc >= 2 && strcmp(argv[1], "bench") == 0;
+    if ((argc >= 2 && !convert && !bench) || (convert && argc < 4) || (bench && argc < 4))
+    {
+        printf("Usage: %s [convert <edges.txt> <graph.bin> [directed]]\n", argv[0]);
+        printf("       %s [bench <rmat|grid|er> <scale> [repetitions] [warmup] [seed] [none|rcm|degree|bfs]]\n",
+               argv[0]);
+        printf("Without arguments the demo runs.\n");
+        return 1;
+    }
+
+    // graphs convert <edges.txt> <graph.bin> [directed]
+    if (convert)
+    {
+        int directed = argc >= 5 && strcmp(argv[4], "directed") == 0;
+        return convertEdgeList(argv[2], argv[3], directed) ? 0 : 1;
+    }
+
+    // graphs bench <rmat|grid|er> <scale> [repetitions] [warmup] [seed] [none|rcm|degree|bfs]
+    if (bench)
+    {
+        int repetitions = argc >= 5 ? atoi(argv[4]) : 5;
+        int warmup = argc >= 6 ? atoi(argv[5]) : 1;
+        uint64_t seed = argc >= 7 ? strtoull(argv[6], NULL, 10) : 1;
+        const char *orderName = argc >= 8 ? argv[7] : "none";
+        return benchmarkGraphs(argv[2], atoi(argv[3]), repetitions, warmup, seed, orderName);
+    }
+
+    int vertices = 6;
+
+    // Weighted, undirected edge list
+    Edge edges[] = {
+        {0, 1, 2}, {0, 2, 4}, {1, 3, 1}, {2, 4, 3}, {3, 5, 7}};
+    Graph *graph = buildGraph(edges, 5, vertices, 0);
+
+    // BFS and DFS Traversals
+    BFS(graph, 0);
+    DFS(graph, 0);
+
+    // Direction-optimizing BFS returns the BFS tree instead of printing
+    int bfsParent[6], bfsLevel[6];
+    bfsDirectionOptimizing(graph, 0, bfsParent, bfsLevel);
+    printf("BFS Levels:");
+    for (int i = 0; i < vertices; i++)
+    {
+        printf(" %d(parent %d, level %d)", i, bfsParent[i], bfsLevel[i]);
+    }
+    printf("\n");
+
+    // One multi-source sweep answers the BFS distances of several sources
+    int msSources[] = {0, 5};
+    int msDist[2 * 6];
+    multiSourceBfs(graph, msSources, 2, msDist);
+    for (int i = 0; i < 2; i++)
+    {
+        printf("Hops from %d:", msSources[i]);
+        for (int v = 0; v < vertices; v++)
+        {
+            printf(" %d", msDist[i * vertices + v]);
+        }
+        printf("\n");
+    }
+
+    // Topological sort, cycle detection and SCCs on a directed graph
+    Edge arcs[] = {
+        {0, 1, 1}, {1, 2, 1}, {2, 0, 1}, {2, 3, 1}, {3, 4, 1}, {4, 5, 1}, {5, 3, 1}};
+    Graph *directed = buildGraph(arcs, 7, vertices, 1);
+    int component[6];
+    int components = stronglyConnectedComponents(directed, component);
+    printf("Strongly Connected Components: %d (", components);
+    for (int i = 0; i < vertices; i++)
+    {
+        printf(i > 0 ? " %d" : "%d", component[i]);
+    }
+    printf(")\n");
+    printf("Directed graph %s; undirected graph %s.\n",
+           hasCycle(directed) ? "has a cycle" : "is acyclic", hasCycle(graph) ? "has a cycle" : "is acyclic");
+
+    Edge dagArcs[] = {
+        {5, 2, 1}, {5, 0, 1}, {4, 0, 1}, {4, 1, 1}, {2, 3, 1}, {3, 1, 1}};
+    Graph *dag = buildGraph(dagArcs, 6, vertices, 1);
+    int order[6];
+    if (topologicalSort(dag, order))
+    {
+        printf("Topological Order:");
+        for (int i = 0; i < vertices; i++)
+        {
+            printf(" %d", order[i]);
+        }
+        printf("\n");
+    }
+    freeGraph(dag);
+    freeGraph(directed);
+
+    // Dijkstra's Algorithm
+    dijkstra(graph, 0);
+
+    // Radix heap mode must agree with the d-ary heap
+    long long heapDist[6], radixDist[6];
+    int heapParent[6], radixParent[6];
+    dijkstraHeap(graph, 0, heapDist, heapParent);
+    dijkstraRadix(graph, 0, radixDist, radixParent);
+    int sameDistances = 1;
+    for (int i = 0; i < vertices; i++)
+    {
+        sameDistances &= heapDist[i] == radixDist[i];
+    }
+    printf("Radix heap distances %s the d-ary heap.\n", sameDistances ? "match" : "differ from");
+
+    // Delta-stepping must agree as well, whatever the bucket width
+    long long deltaDist[6];
+    deltaStepping(graph, 0, 3, deltaDist);
+    sameDistances = 1;
+    for (int i = 0; i < vertices; i++)
+    {
+        sameDistances &= heapDist[i] == deltaDist[i];
+    }
+    printf("Delta-stepping distances %s Dijkstra.\n", sameDistances ? "match" : "differ from");
+
+    // Kruskal's MST
+    kruskal(graph);
+
+    // Streaming connectivity: edges arrive in batches from any thread
+    ConcurrentDSU *dsu = createConcurrentDSU(vertices);
+    Edge firstBatch[] = {{0, 1, 0}, {2, 4, 0}};
+    Edge secondBatch[] = {{1, 3, 0}};
+    concurrentUnionEdges(dsu, firstBatch, 2);
+    concurrentUnionEdges(dsu, secondBatch, 1);
+    printf("Streaming connectivity: 0~3 %s, 0~4 %s\n",
+           concurrentSameSet(dsu, 0, 3) ? "yes" : "no", concurrentSameSet(dsu, 0, 4) ? "yes" : "no");
+    freeConcurrentDSU(dsu);
+
+    int labels[6];
+    printf("Connected Components: %d\n", connectedComponents(graph, labels));
+
+    // Boruvka and Prim find spanning trees of the same weight
+    Edge mstEdges[6];
+    long long boruvkaWeight, primWeight;
+    int boruvkaCount = boruvka(graph, mstEdges, &boruvkaWeight);
+    printSpanningTree(graph, "Boruvka's Minimum Spanning Tree", mstEdges, boruvkaCount, boruvkaWeight);
+    int primCount = prim(graph, mstEdges, &primWeight);
+    printf("Prim's Minimum Spanning Tree: %d edges, total weight %lld\n", primCount, primWeight);
+
+    // Keep shortest paths current while the graph changes
+    DynamicGraph *dynamic = createDynamicGraphFrom(graph);
+    IncrementalSssp *sssp = createIncrementalSssp(dynamic, 0);
+    EdgeUpdate batch[] = {{EDGE_INSERT, 0, 5, 6}, {EDGE_DELETE, 0, 1, 0}, {EDGE_UPDATE, 2, 4, 1}};
+    int recomputed = updateIncrementalSssp(sssp, batch, 3);
+    printf("After updates (%d vertices recomputed):", recomputed);
+    for (int i = 0; i < vertices; i++)
+    {
+        printf(" %lld", sssp->dist[i]);
+    }
+    printf("\n");
+    freeIncrementalSssp(sssp);
+    freeDynamicGraph(dynamic);
+
+    // Relabel for locality; traversals still speak the caller's vertex ids
+    Graph *reordered = reorderGraph(graph, ORDER_RCM);
+    printf("RCM order:");
+    for (int i = 0; i < vertices; i++)
+    {
+        printf(" %d", originalVertex(reordered, i));
+    }
+    printf("\n");
+    BFS(reordered, 0);
+    dijkstra(reordered, 0);
+    freeGraph(reordered);
+
+    // Round trip through the binary format and open it zero-copy
+    const char *graphFile = "graphs_demo.bin";
+    if (saveGraph(graph, graphFile))
+    {
+        Graph *mapped = mapGraph(graphFile);
+        if (mapped != NULL)
+        {
+            printf("Mapped %s: %d vertices, %ld arcs.\n", graphFile, mapped->vertices, mapped->arcs);
+            BFS(mapped, 0);
+            freeGraph(mapped);
+        }
+        remove(graphFile);
+    }
 
+    freeGraph(graph);
     return 0;
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "nodepool.h"
+
 // Define structure for a linked list node
 typedef struct Node
 {
@@ -8,15 +10,13 @@ typedef struct Node
     struct Node *next;
 } Node;
 
+// Every list node comes from this pool
+NodePool listNodes = NODE_POOL_INIT(Node, 1024);
+
 // Function to create a new node
 Node *createNode(int data)
 {
-    Node *newNode = (Node *)malloc(sizeof(Node));
-    if (newNode == NULL)
-    {
-        printf("Memory allocation failed.\n");
-        exit(1);
-    }
+    Node *newNode = (Node *)poolAlloc(&listNodes);
     newNode->data = data;
     newNode->next = NULL;
     return newNode;
@@ -64,7 +64,7 @@ Node *insertAtPosition(Node *head, int data, int position)
     if (temp == NULL)
     {
         printf("Position out of bounds.\n");
-        free(newNode);
+        poolFree(&listNodes, newNode);
         return head;
     }
     newNode->next = temp->next;
@@ -82,7 +82,7 @@ Node *deleteFromBeginning(Node *head)
     }
     Node *temp = head;
     head = head->next;
-    free(temp);
+    poolFree(&listNodes, temp);
     return head;
 }
 
@@ -96,7 +96,7 @@ Node *deleteFromEnd(Node *head)
     }
     if (head->next == NULL)
     {
-        free(head);
+        poolFree(&listNodes, head);
         return NULL;
     }
     Node *temp = head;
@@ -104,7 +104,7 @@ Node *deleteFromEnd(Node *head)
     {
         temp = temp->next;
     }
-    free(temp->next);
+    poolFree(&listNodes, temp->next);
     temp->next = NULL;
     return head;
 }
@@ -121,7 +121,7 @@ Node *deleteAtPosition(Node *head, int position)
     {
         Node *temp = head;
         head = head->next;
-        free(temp);
+        poolFree(&listNodes, temp);
         return head;
     }
     Node *temp = head;
@@ -136,7 +136,7 @@ Node *deleteAtPosition(Node *head, int position)
     }
     Node *deleteNode = temp->next;
     temp->next = deleteNode->next;
-    free(deleteNode);
+    poolFree(&listNodes, deleteNode);
     return head;
 }
 
@@ -189,6 +189,17 @@ Node *reverseList(Node *head)
     return prev;
 }
 
+// Function to free every node of the list
+void freeList(Node *head)
+{
+    while (head != NULL)
+    {
+        Node *next = head->next;
+        poolFree(&listNodes, head);
+        head = next;
+    }
+}
+
 // Main function
 int main()
 {
@@ -216,5 +227,20 @@ int main()
     printf("Reversed Linked List:\n");
     traverseList(head);
 
+    freeList(head);
+
+    // Churn reuses freed nodes instead of going back to malloc
+    for (int round = 0; round < 1000; round++)
+    {
+        Node *list = NULL;
+        for (int i = 0; i < 1000; i++)
+        {
+            list = insertAtBeginning(list, i);
+        }
+        freeList(list);
+    }
+    printPoolStats(&listNodes, "List node");
+    poolRelease(&listNodes);
+
     return 0;
 }
\ No newline at end of file
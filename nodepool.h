@@ -0,0 +1,141 @@
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Slab allocator for fixed-size nodes. Nodes are carved out of large slabs
+// and freed nodes go on a free list that the next allocation pops, so
+// steady churn never reaches malloc. Use one pool per node type; a pool can
+// also hand every node back at once, either keeping its slabs for reuse
+// (poolReset) or returning them to the system (poolRelease).
+
+// Counters kept by every pool
+typedef struct NodePoolStats
+{
+    size_t allocations;   // Nodes handed out
+    size_t frees;         // Nodes returned one at a time
+    size_t live;          // Nodes currently in use
+    size_t peak;          // Most nodes in use at once
+    size_t slabs;         // Slabs obtained from malloc
+    size_t bytesReserved; // Memory held in slabs
+} NodePoolStats;
+
+typedef struct NodePool
+{
+    size_t nodeSize;   // Bytes per node, rounded up to pointer alignment
+    size_t slabNodes;  // Nodes per slab
+    void *freeList;    // Returned nodes, linked through their first word
+    char **slabList;   // Every slab, in allocation order
+    size_t slabCapacity;
+    size_t slabCursor; // Slab currently being carved
+    size_t carved;     // Nodes carved from the current slab
+    NodePoolStats stats;
+} NodePool;
+
+// Node size padded so every node can hold the free-list link and stays
+// pointer aligned
+#define POOL_NODE_SIZE(type) \
+    (((sizeof(type) < sizeof(void *) ? sizeof(void *) : sizeof(type)) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *))
+
+// Static initializer for a pool of the given node type, e.g.
+// NodePool pool = NODE_POOL_INIT(Node, 1024);
+#define NODE_POOL_INIT(type, nodesPerSlab) {POOL_NODE_SIZE(type), (nodesPerSlab), NULL, NULL, 0, 0, 0, {0, 0, 0, 0, 0, 0}}
+
+// Abort the program when the system is out of memory
+static inline void *poolSystemAlloc(void *memory)
+{
+    if (memory == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    return memory;
+}
+
+// Get an uninitialized node
+static inline void *poolAlloc(NodePool *pool)
+{
+    void *node = pool->freeList;
+    if (node != NULL)
+    {
+        pool->freeList = *(void **)node;
+    }
+    else
+    {
+        // Move on to the next slab when this one is used up; slabs kept by
+        // poolReset are carved again before new ones are allocated
+        if (pool->slabCursor == pool->stats.slabs || pool->carved == pool->slabNodes)
+        {
+            if (pool->slabCursor < pool->stats.slabs)
+            {
+                pool->slabCursor++;
+            }
+            if (pool->slabCursor == pool->stats.slabs)
+            {
+                if (pool->stats.slabs == pool->slabCapacity)
+                {
+                    pool->slabCapacity = pool->slabCapacity > 0 ? pool->slabCapacity * 2 : 8;
+                    pool->slabList = (char **)poolSystemAlloc(realloc(pool->slabList, pool->slabCapacity * sizeof(char *)));
+                }
+                pool->slabList[pool->stats.slabs++] = (char *)poolSystemAlloc(malloc(pool->nodeSize * pool->slabNodes));
+                pool->stats.bytesReserved += pool->nodeSize * pool->slabNodes;
+            }
+            pool->carved = 0;
+        }
+        node = pool->slabList[pool->slabCursor] + pool->carved * pool->nodeSize;
+        pool->carved++;
+    }
+    pool->stats.allocations++;
+    pool->stats.live++;
+    if (pool->stats.live > pool->stats.peak)
+    {
+        pool->stats.peak = pool->stats.live;
+    }
+    return node;
+}
+
+// Return one node to its pool
+static inline void poolFree(NodePool *pool, void *node)
+{
+    *(void **)node = pool->freeList;
+    pool->freeList = node;
+    pool->stats.frees++;
+    pool->stats.live--;
+}
+
+// Hand back every node of the pool at once but keep the slabs for reuse;
+// all nodes from the pool become invalid
+static inline void poolReset(NodePool *pool)
+{
+    pool->freeList = NULL;
+    pool->slabCursor = 0;
+    pool->carved = 0;
+    pool->stats.live = 0;
+}
+
+// Hand back every node and return the slabs to the system; the pool can be
+// used again afterwards
+static inline void poolRelease(NodePool *pool)
+{
+    for (size_t i = 0; i < pool->stats.slabs; i++)
+    {
+        free(pool->slabList[i]);
+    }
+    free(pool->slabList);
+    pool->slabList = NULL;
+    pool->slabCapacity = 0;
+    pool->stats.slabs = 0;
+    pool->stats.bytesReserved = 0;
+    poolReset(pool);
+}
+
+// Print the counters of a pool under a name
+static inline void printPoolStats(const NodePool *pool, const char *name)
+{
+    printf("%s pool: %zu allocations, %zu frees, %zu live, peak %zu, %zu slabs (%zu bytes)\n", name,
+           pool->stats.allocations, pool->stats.frees, pool->stats.live, pool->stats.peak, pool->stats.slabs,
+           pool->stats.bytesReserved);
+}
+
+#endif
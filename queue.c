@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "nodepool.h"
+
 // Define structure for a queue node
 typedef struct QueueNode
 {
@@ -8,22 +10,19 @@ typedef struct QueueNode
     struct QueueNode *next;
 } QueueNode;
 
-// Define structure for the queue
+// Define structure for the queue; its nodes come from its own pool so
+// clearing the queue releases them all at once
 typedef struct Queue
 {
     QueueNode *front;
     QueueNode *rear;
+    NodePool nodes;
 } Queue;
 
 // Function to create a new node
-QueueNode *createQueueNode(int data)
+QueueNode *createQueueNode(Queue *queue, int data)
 {
-    QueueNode *newNode = (QueueNode *)malloc(sizeof(QueueNode));
-    if (newNode == NULL)
-    {
-        printf("Memory allocation failed.\n");
-        exit(1);
-    }
+    QueueNode *newNode = (QueueNode *)poolAlloc(&queue->nodes);
     newNode->data = data;
     newNode->next = NULL;
     return newNode;
@@ -38,8 +37,10 @@ Queue *initializeQueue()
         printf("Memory allocation failed.\n");
         exit(1);
     }
+    NodePool nodes = NODE_POOL_INIT(QueueNode, 256);
     queue->front = NULL;
     queue->rear = NULL;
+    queue->nodes = nodes;
     return queue;
 }
 
@@ -52,7 +53,7 @@ int isQueueEmpty(Queue *queue)
 // Function to enqueue an element
 void enqueue(Queue *queue, int data)
 {
-    QueueNode *newNode = createQueueNode(data);
+    QueueNode *newNode = createQueueNode(queue, data);
     if (isQueueEmpty(queue))
     {
         queue->front = queue->rear = newNode;
@@ -80,7 +81,7 @@ int dequeue(Queue *queue)
     {
         queue->rear = NULL;
     }
-    free(temp);
+    poolFree(&queue->nodes, temp);
     return dequeuedData;
 }
 
@@ -116,10 +117,7 @@ void traverseQueue(Queue *queue)
 // Function to clear the queue
 void clearQueue(Queue *queue)
 {
-    while (!isQueueEmpty(queue))
-    {
-        dequeue(queue);
-    }
+    poolRelease(&queue->nodes);
     free(queue);
     printf("Queue cleared and memory released.\n");
 }
@@ -144,6 +142,7 @@ int main()
     printf("Queue after dequeuing an element:\n");
     traverseQueue(queue);
 
+    printPoolStats(&queue->nodes, "Queue node");
     clearQueue(queue);
 
     return 0;
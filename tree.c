@@ -1,57 +1,371 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-// Structure for tree nodes
+#include "nodepool.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Structure for tree nodes. height is the number of nodes on the longest
+// path down to a leaf (1 for a leaf); it sits in what would otherwise be
+// padding and is what the AVL functions balance on.
 typedef struct Node
 {
     int data;
+    int height;
     struct Node *left;
     struct Node *right;
 } Node;
 
+// Every tree node comes from this pool
+NodePool treeNodes = NODE_POOL_INIT(Node, 1024);
+
 // Helper function to create a new node
 Node *createNode(int data)
 {
-    Node *newNode = (Node *)malloc(sizeof(Node));
+    Node *newNode = (Node *)poolAlloc(&treeNodes);
     newNode->data = data;
+    newNode->height = 1;
     newNode->left = NULL;
     newNode->right = NULL;
     return newNode;
 }
 
-// Binary Tree Traversals
-void inorder(Node *root)
+// Binary Tree Traversals. None of them recurse, so a degenerate tree of any
+// depth is safe; values are handed to the caller instead of printed.
+typedef enum TraversalOrder
 {
-    if (root != NULL)
+    TRAVERSE_INORDER,
+    TRAVERSE_PREORDER,
+    TRAVERSE_POSTORDER
+} TraversalOrder;
+
+// Pull-style traversal over an explicit stack of pending nodes
+typedef struct TreeIterator
+{
+    TraversalOrder order;
+    Node **stack;
+    long depth;
+    long capacity;
+    Node *current;     // Next subtree to descend into (in- and postorder)
+    Node *lastVisited; // Node returned last (postorder)
+} TreeIterator;
+
+void pushNode(TreeIterator *it, Node *node)
+{
+    if (it->depth == it->capacity)
     {
-        inorder(root->left);
-        printf("%d ", root->data);
-        inorder(root->right);
+        it->capacity = it->capacity > 0 ? it->capacity * 2 : 64;
+        Node **grown = (Node **)realloc(it->stack, it->capacity * sizeof(Node *));
+        if (grown == NULL)
+        {
+            printf("Memory allocation failed.\n");
+            exit(1);
+        }
+        it->stack = grown;
     }
+    it->stack[it->depth++] = node;
 }
 
-void preorder(Node *root)
+// Start a traversal of a tree in the given order
+void initIterator(TreeIterator *it, Node *root, TraversalOrder order)
 {
-    if (root != NULL)
+    it->order = order;
+    it->stack = NULL;
+    it->depth = 0;
+    it->capacity = 0;
+    it->current = root;
+    it->lastVisited = NULL;
+    if (order == TRAVERSE_PREORDER && root != NULL)
     {
-        printf("%d ", root->data);
-        preorder(root->left);
-        preorder(root->right);
+        pushNode(it, root);
     }
 }
 
-void postorder(Node *root)
+// Next node of the traversal, or NULL once it is exhausted. The tree must
+// not change while it is being iterated.
+Node *nextNode(TreeIterator *it)
+{
+    if (it->order == TRAVERSE_PREORDER)
+    {
+        if (it->depth == 0)
+        {
+            return NULL;
+        }
+        Node *node = it->stack[--it->depth];
+        if (node->right != NULL)
+        {
+            pushNode(it, node->right);
+        }
+        if (node->left != NULL)
+        {
+            pushNode(it, node->left);
+        }
+        return node;
+    }
+
+    while (1)
+    {
+        for (; it->current != NULL; it->current = it->current->left)
+        {
+            pushNode(it, it->current);
+        }
+        if (it->depth == 0)
+        {
+            return NULL;
+        }
+        Node *top = it->stack[it->depth - 1];
+        if (it->order == TRAVERSE_INORDER)
+        {
+            it->depth--;
+            it->current = top->right;
+            return top;
+        }
+        // Postorder: a node is done once its right subtree is
+        if (top->right != NULL && it->lastVisited != top->right)
+        {
+            it->current = top->right;
+            continue;
+        }
+        it->depth--;
+        it->lastVisited = top;
+        return top;
+    }
+}
+
+void freeIterator(TreeIterator *it)
+{
+    free(it->stack);
+    it->stack = NULL;
+}
+
+// Hand every value to visit in the given order; returns the number of nodes
+long traverse(Node *root, TraversalOrder order, void (*visit)(int value, void *context), void *context)
+{
+    TreeIterator it;
+    initIterator(&it, root, order);
+    long count = 0;
+    for (Node *node = nextNode(&it); node != NULL; node = nextNode(&it))
+    {
+        visit(node->data, context);
+        count++;
+    }
+    freeIterator(&it);
+    return count;
+}
+
+// Write up to capacity values to buffer in the given order; returns how
+// many were written
+long traverseToBuffer(Node *root, TraversalOrder order, int *buffer, long capacity)
+{
+    TreeIterator it;
+    initIterator(&it, root, order);
+    long count = 0;
+    for (Node *node; count < capacity && (node = nextNode(&it)) != NULL; count++)
+    {
+        buffer[count] = node->data;
+    }
+    freeIterator(&it);
+    return count;
+}
+
+// Morris inorder traversal: O(1) extra space. Before descending left, the
+// rightmost node of the left subtree is pointed back at the current node;
+// the thread is found again on the way back up and removed, so the tree is
+// unchanged afterwards. Every edge is walked at most three times.
+long morrisInorder(Node *root, void (*visit)(int value, void *context), void *context)
+{
+    long count = 0;
+    Node *node = root;
+    while (node != NULL)
+    {
+        if (node->left == NULL)
+        {
+            visit(node->data, context);
+            count++;
+            node = node->right;
+            continue;
+        }
+        Node *predecessor = node->left;
+        while (predecessor->right != NULL && predecessor->right != node)
+        {
+            predecessor = predecessor->right;
+        }
+        if (predecessor->right == NULL)
+        {
+            predecessor->right = node;
+            node = node->left;
+        }
+        else
+        {
+            predecessor->right = NULL;
+            visit(node->data, context);
+            count++;
+            node = node->right;
+        }
+    }
+    return count;
+}
+
+// Morris preorder traversal: as morrisInorder, but a node is visited when
+// its thread is laid rather than when it is removed
+long morrisPreorder(Node *root, void (*visit)(int value, void *context), void *context)
 {
-    if (root != NULL)
+    long count = 0;
+    Node *node = root;
+    while (node != NULL)
     {
-        postorder(root->left);
-        postorder(root->right);
-        printf("%d ", root->data);
+        if (node->left == NULL)
+        {
+            visit(node->data, context);
+            count++;
+            node = node->right;
+            continue;
+        }
+        Node *predecessor = node->left;
+        while (predecessor->right != NULL && predecessor->right != node)
+        {
+            predecessor = predecessor->right;
+        }
+        if (predecessor->right == NULL)
+        {
+            visit(node->data, context);
+            count++;
+            predecessor->right = node;
+            node = node->left;
+        }
+        else
+        {
+            predecessor->right = NULL;
+            node = node->right;
+        }
     }
+    return count;
 }
 
-// Insert into a Binary Search Tree
+void printValue(int value, void *context)
+{
+    (void)context;
+    printf("%d ", value);
+}
+
+void inorder(Node *root)
+{
+    traverse(root, TRAVERSE_INORDER, printValue, NULL);
+}
+
+void preorder(Node *root)
+{
+    traverse(root, TRAVERSE_PREORDER, printValue, NULL);
+}
+
+void postorder(Node *root)
+{
+    traverse(root, TRAVERSE_POSTORDER, printValue, NULL);
+}
+
+// Insert into a Binary Search Tree without recursion. The first descent
+// links the new leaf and counts its depth; the second walks the same path
+// and raises each ancestor's height to cover the leaf.
 Node *insertBST(Node *root, int data)
+{
+    Node **link = &root;
+    int depth = 0;
+    while (*link != NULL)
+    {
+        link = data < (*link)->data ? &(*link)->left : &(*link)->right;
+        depth++;
+    }
+    *link = createNode(data);
+
+    Node *node = root;
+    for (int level = 0; level < depth; level++)
+    {
+        if (node->height < depth - level + 1)
+        {
+            node->height = depth - level + 1;
+        }
+        node = data < node->data ? node->left : node->right;
+    }
+    return root;
+}
+
+// Search in a Binary Search Tree
+Node *searchBST(Node *root, int key)
+{
+    while (root != NULL && root->data != key)
+    {
+        root = key < root->data ? root->left : root->right;
+    }
+    return root;
+}
+
+// Stored height of a subtree, 0 for an empty one
+int nodeHeight(Node *node)
+{
+    return node != NULL ? node->height : 0;
+}
+
+// Recompute a node's height from its children
+void updateHeight(Node *node)
+{
+    int leftHeight = nodeHeight(node->left);
+    int rightHeight = nodeHeight(node->right);
+    node->height = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+}
+
+// Rotate a subtree right around its left child and return the new root
+Node *rotateRight(Node *root)
+{
+    Node *pivot = root->left;
+    root->left = pivot->right;
+    pivot->right = root;
+    updateHeight(root);
+    updateHeight(pivot);
+    return pivot;
+}
+
+// Rotate a subtree left around its right child and return the new root
+Node *rotateLeft(Node *root)
+{
+    Node *pivot = root->right;
+    root->right = pivot->left;
+    pivot->left = root;
+    updateHeight(root);
+    updateHeight(pivot);
+    return pivot;
+}
+
+// Restore the AVL property at a node whose subtrees differ in height by at
+// most two, and return the root of the rebalanced subtree
+Node *rebalance(Node *root)
+{
+    updateHeight(root);
+    int balanceFactor = nodeHeight(root->left) - nodeHeight(root->right);
+    if (balanceFactor > 1)
+    {
+        if (nodeHeight(root->left->left) < nodeHeight(root->left->right))
+        {
+            root->left = rotateLeft(root->left);
+        }
+        return rotateRight(root);
+    }
+    if (balanceFactor < -1)
+    {
+        if (nodeHeight(root->right->right) < nodeHeight(root->right->left))
+        {
+            root->right = rotateRight(root->right);
+        }
+        return rotateLeft(root);
+    }
+    return root;
+}
+
+// Insert into an AVL tree, keeping its height within 1.44 log2(n); a key
+// that is already present is left alone. Returns the new root.
+Node *insertAVL(Node *root, int data)
 {
     if (root == NULL)
     {
@@ -59,56 +373,693 @@ Node *insertBST(Node *root, int data)
     }
     if (data < root->data)
     {
-        root->left = insertBST(root->left, data);
+        root->left = insertAVL(root->left, data);
+    }
+    else if (data > root->data)
+    {
+        root->right = insertAVL(root->right, data);
     }
     else
     {
-        root->right = insertBST(root->right, data);
+        return root;
     }
-    return root;
+    return rebalance(root);
 }
 
-// Search in a Binary Search Tree
-Node *searchBST(Node *root, int key)
+// Delete a key from an AVL tree and return the new root
+Node *deleteAVL(Node *root, int data)
 {
-    if (root == NULL || root->data == key)
+    if (root == NULL)
     {
-        return root;
+        return NULL;
+    }
+    if (data < root->data)
+    {
+        root->left = deleteAVL(root->left, data);
     }
-    if (key < root->data)
+    else if (data > root->data)
     {
-        return searchBST(root->left, key);
+        root->right = deleteAVL(root->right, data);
+    }
+    else if (root->left == NULL || root->right == NULL)
+    {
+        Node *child = root->left != NULL ? root->left : root->right;
+        poolFree(&treeNodes, root);
+        return child;
     }
     else
     {
-        return searchBST(root->right, key);
+        // Take over the smallest key of the right subtree, then remove it there
+        Node *successor = root->right;
+        while (successor->left != NULL)
+        {
+            successor = successor->left;
+        }
+        root->data = successor->data;
+        root->right = deleteAVL(root->right, successor->data);
     }
+    return rebalance(root);
 }
 
-// Check height of the tree (used for AVL balance check)
-int height(Node *root)
+// Node with the smallest key, or NULL for an empty tree
+Node *minNode(Node *root)
+{
+    while (root != NULL && root->left != NULL)
+    {
+        root = root->left;
+    }
+    return root;
+}
+
+// Node with the smallest key greater than the given one, or NULL. Walks down
+// from the root, so in-order iteration needs no parent pointers and costs
+// O(log n) per step on a balanced tree.
+Node *nextInOrder(Node *root, int data)
+{
+    Node *next = NULL;
+    while (root != NULL)
+    {
+        if (data < root->data)
+        {
+            next = root;
+            root = root->left;
+        }
+        else
+        {
+            root = root->right;
+        }
+    }
+    return next;
+}
+
+// Release every node of a tree. Left children are rotated up until the
+// root has none, so the walk needs neither recursion nor a stack.
+void freeTree(Node *root)
+{
+    while (root != NULL)
+    {
+        if (root->left != NULL)
+        {
+            Node *pivot = root->left;
+            root->left = pivot->right;
+            pivot->right = root;
+            root = pivot;
+        }
+        else
+        {
+            Node *next = root->right;
+            poolFree(&treeNodes, root);
+            root = next;
+        }
+    }
+}
+
+// Pending node of an iterative postorder walk over subtree heights
+typedef struct HeightFrame
+{
+    Node *node;
+    int leftHeight;
+    int stage; // 0: left subtree next, 1: right subtree next, 2: both done
+} HeightFrame;
+
+// Height of a tree computed bottom-up in one postorder pass with an explicit
+// stack. With stopIfUnbalanced set, returns -1 as soon as some node's
+// subtrees differ in height by more than one.
+int subtreeHeight(Node *root, int stopIfUnbalanced)
 {
     if (root == NULL)
     {
         return 0;
     }
-    int leftHeight = height(root->left);
-    int rightHeight = height(root->right);
-    return (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+    long depth = 0, capacity = 64;
+    HeightFrame *stack = (HeightFrame *)malloc(capacity * sizeof(HeightFrame));
+    int returned = 0;
+    if (stack == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    stack[depth++] = (HeightFrame){root, 0, 0};
+    while (depth > 0)
+    {
+        HeightFrame *frame = &stack[depth - 1];
+        Node *child = NULL;
+        if (frame->stage == 0)
+        {
+            frame->stage = 1;
+            child = frame->node->left;
+            returned = 0;
+        }
+        else if (frame->stage == 1)
+        {
+            frame->leftHeight = returned;
+            frame->stage = 2;
+            child = frame->node->right;
+            returned = 0;
+        }
+        if (child != NULL)
+        {
+            if (depth == capacity)
+            {
+                capacity *= 2;
+                HeightFrame *grown = (HeightFrame *)realloc(stack, capacity * sizeof(HeightFrame));
+                if (grown == NULL)
+                {
+                    printf("Memory allocation failed.\n");
+                    exit(1);
+                }
+                stack = grown;
+            }
+            stack[depth++] = (HeightFrame){child, 0, 0};
+            continue;
+        }
+        if (frame->stage == 1)
+        {
+            continue; // Left subtree was empty; move on to the right one
+        }
+
+        int leftHeight = frame->leftHeight;
+        int rightHeight = returned;
+        if (stopIfUnbalanced && abs(leftHeight - rightHeight) > 1)
+        {
+            free(stack);
+            return -1;
+        }
+        returned = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+        depth--;
+    }
+    free(stack);
+    return returned;
 }
 
-// Check if a tree is balanced (AVL property demonstration)
+// Check height of the tree
+int height(Node *root)
+{
+    return subtreeHeight(root, 0);
+}
+
+// Check if a tree is balanced (AVL property demonstration) in a single O(n)
+// pass instead of recomputing heights at every node
 int isBalanced(Node *root)
 {
-    if (root == NULL)
+    return subtreeHeight(root, 1) >= 0;
+}
+
+// B+tree: keys and values live only in the leaves, which are chained for
+// range scans; inner nodes hold separators and child pointers. Both node
+// kinds are sized to 256 bytes and allocated on cache-line boundaries, so a
+// node is exactly four lines and a level costs a few adjacent line fills
+// instead of one miss per key as with Node.
+#define BPLUS_LEAF_KEYS 30
+#define BPLUS_INNER_KEYS 20
+
+typedef struct BPlusLeaf
+{
+    int count;
+    int keys[BPLUS_LEAF_KEYS];
+    int values[BPLUS_LEAF_KEYS];
+    struct BPlusLeaf *next;
+} BPlusLeaf;
+
+// children[i] holds the keys below keys[i]; children[count] the rest
+typedef struct BPlusInner
+{
+    int count;
+    int keys[BPLUS_INNER_KEYS];
+    void *children[BPLUS_INNER_KEYS + 1];
+} BPlusInner;
+
+// All leaves are at the same depth, so the height says what a node is
+// without storing a flag in every node
+typedef struct BPlusTree
+{
+    void *root;
+    int height; // Inner levels above the leaves
+    long size;
+    long nodes;
+} BPlusTree;
+
+// Allocate zeroed memory or abort the program
+void *allocateNode(size_t size)
+{
+    void *memory = calloc(1, size);
+    if (memory == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    return memory;
+}
+
+// Allocate a zeroed B+tree node aligned to a cache line or abort the program
+void *allocateBPlusNode(size_t size)
+{
+    void *memory;
+    if (posix_memalign(&memory, 64, size) != 0)
+    {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    memset(memory, 0, size);
+    return memory;
+}
+
+// Create an empty B+tree (a single empty leaf)
+BPlusTree *createBPlusTree()
+{
+    BPlusTree *tree = (BPlusTree *)allocateNode(sizeof(BPlusTree));
+    tree->root = allocateBPlusNode(sizeof(BPlusLeaf));
+    tree->height = 0;
+    tree->size = 0;
+    tree->nodes = 1;
+    return tree;
+}
+
+// Release the nodes below a subtree of the given inner height
+void freeBPlusNode(void *node, int height)
+{
+    if (height > 0)
+    {
+        BPlusInner *inner = (BPlusInner *)node;
+        for (int i = 0; i <= inner->count; i++)
+        {
+            freeBPlusNode(inner->children[i], height - 1);
+        }
+    }
+    free(node);
+}
+
+void freeBPlusTree(BPlusTree *tree)
+{
+    freeBPlusNode(tree->root, tree->height);
+    free(tree);
+}
+
+// Number of keys below the given one. The comparisons are summed instead of
+// branched on, four lanes at a time with SSE2, so the scan has no
+// mispredictions; a node is only a few cache lines, which the hardware
+// prefetcher streams in.
+int countLess(const int *keys, int count, int key)
+{
+    int position = 0;
+    int i = 0;
+#ifdef __SSE2__
+    __m128i needle = _mm_set1_epi32(key);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i less = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i *)(keys + i)), needle);
+        position += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(less)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        position += keys[i] < key;
+    }
+    return position;
+}
+
+// Number of keys not above the given one: the child an inner node routes to
+int countNotGreater(const int *keys, int count, int key)
+{
+    int position = 0;
+    int i = 0;
+#ifdef __SSE2__
+    __m128i needle = _mm_set1_epi32(key);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i greater = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(keys + i)), needle);
+        position += 4 - __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(greater)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        position += keys[i] <= key;
+    }
+    return position;
+}
+
+// Leaf whose range covers a key
+BPlusLeaf *findLeaf(const BPlusTree *tree, int key)
+{
+    void *node = tree->root;
+    for (int level = tree->height; level > 0; level--)
+    {
+        BPlusInner *inner = (BPlusInner *)node;
+        node = inner->children[countNotGreater(inner->keys, inner->count, key)];
+    }
+    return (BPlusLeaf *)node;
+}
+
+// Look a key up; stores its value and returns 1 if present
+int bplusSearch(const BPlusTree *tree, int key, int *value)
+{
+    BPlusLeaf *leaf = findLeaf(tree, key);
+    int position = countLess(leaf->keys, leaf->count, key);
+    if (position < leaf->count && leaf->keys[position] == key)
     {
+        *value = leaf->values[position];
+        return 1;
+    }
+    return 0;
+}
+
+// Insert below a node. When the node has to split, the new right sibling and
+// the smallest key under it are returned through split and separator.
+int insertBPlusNode(BPlusTree *tree, void *node, int height, int key, int value, void **split, int *separator)
+{
+    if (height == 0)
+    {
+        BPlusLeaf *leaf = (BPlusLeaf *)node;
+        int position = countLess(leaf->keys, leaf->count, key);
+        if (position < leaf->count && leaf->keys[position] == key)
+        {
+            leaf->values[position] = value;
+            return 0;
+        }
+        tree->size++;
+        if (leaf->count < BPLUS_LEAF_KEYS)
+        {
+            memmove(leaf->keys + position + 1, leaf->keys + position, (leaf->count - position) * sizeof(int));
+            memmove(leaf->values + position + 1, leaf->values + position, (leaf->count - position) * sizeof(int));
+            leaf->keys[position] = key;
+            leaf->values[position] = value;
+            leaf->count++;
+            return 0;
+        }
+
+        // Split the full leaf around the new key; appends at the right end,
+        // the common case for sorted input, leave the left leaf full
+        int keys[BPLUS_LEAF_KEYS + 1];
+        int values[BPLUS_LEAF_KEYS + 1];
+        memcpy(keys, leaf->keys, position * sizeof(int));
+        memcpy(values, leaf->values, position * sizeof(int));
+        keys[position] = key;
+        values[position] = value;
+        memcpy(keys + position + 1, leaf->keys + position, (BPLUS_LEAF_KEYS - position) * sizeof(int));
+        memcpy(values + position + 1, leaf->values + position, (BPLUS_LEAF_KEYS - position) * sizeof(int));
+        int left = position == BPLUS_LEAF_KEYS && leaf->next == NULL ? BPLUS_LEAF_KEYS : (BPLUS_LEAF_KEYS + 1) / 2;
+
+        BPlusLeaf *right = (BPlusLeaf *)allocateBPlusNode(sizeof(BPlusLeaf));
+        tree->nodes++;
+        leaf->count = left;
+        memcpy(leaf->keys, keys, left * sizeof(int));
+        memcpy(leaf->values, values, left * sizeof(int));
+        right->count = BPLUS_LEAF_KEYS + 1 - left;
+        memcpy(right->keys, keys + left, right->count * sizeof(int));
+        memcpy(right->values, values + left, right->count * sizeof(int));
+        right->next = leaf->next;
+        leaf->next = right;
+        *split = right;
+        *separator = right->keys[0];
         return 1;
     }
-    int leftHeight = height(root->left);
-    int rightHeight = height(root->right);
-    int balanceFactor = abs(leftHeight - rightHeight);
 
-    return balanceFactor <= 1 && isBalanced(root->left) && isBalanced(root->right);
+    BPlusInner *inner = (BPlusInner *)node;
+    int child = countNotGreater(inner->keys, inner->count, key);
+    void *childSplit;
+    int childSeparator;
+    if (!insertBPlusNode(tree, inner->children[child], height - 1, key, value, &childSplit, &childSeparator))
+    {
+        return 0;
+    }
+    if (inner->count < BPLUS_INNER_KEYS)
+    {
+        memmove(inner->keys + child + 1, inner->keys + child, (inner->count - child) * sizeof(int));
+        memmove(inner->children + child + 2, inner->children + child + 1, (inner->count - child) * sizeof(void *));
+        inner->keys[child] = childSeparator;
+        inner->children[child + 1] = childSplit;
+        inner->count++;
+        return 0;
+    }
+
+    // Split the full inner node; the middle separator moves up
+    int keys[BPLUS_INNER_KEYS + 1];
+    void *children[BPLUS_INNER_KEYS + 2];
+    memcpy(keys, inner->keys, child * sizeof(int));
+    keys[child] = childSeparator;
+    memcpy(keys + child + 1, inner->keys + child, (BPLUS_INNER_KEYS - child) * sizeof(int));
+    memcpy(children, inner->children, (child + 1) * sizeof(void *));
+    children[child + 1] = childSplit;
+    memcpy(children + child + 2, inner->children + child + 1, (BPLUS_INNER_KEYS - child) * sizeof(void *));
+    int left = child == BPLUS_INNER_KEYS ? BPLUS_INNER_KEYS - 1 : BPLUS_INNER_KEYS / 2;
+
+    BPlusInner *right = (BPlusInner *)allocateBPlusNode(sizeof(BPlusInner));
+    tree->nodes++;
+    inner->count = left;
+    memcpy(inner->keys, keys, left * sizeof(int));
+    memcpy(inner->children, children, (left + 1) * sizeof(void *));
+    right->count = BPLUS_INNER_KEYS - left;
+    memcpy(right->keys, keys + left + 1, right->count * sizeof(int));
+    memcpy(right->children, children + left + 1, (right->count + 1) * sizeof(void *));
+    *split = right;
+    *separator = keys[left];
+    return 1;
+}
+
+// Insert a key, or replace its value if present
+void bplusInsert(BPlusTree *tree, int key, int value)
+{
+    void *split;
+    int separator;
+    if (insertBPlusNode(tree, tree->root, tree->height, key, value, &split, &separator))
+    {
+        BPlusInner *root = (BPlusInner *)allocateBPlusNode(sizeof(BPlusInner));
+        tree->nodes++;
+        root->count = 1;
+        root->keys[0] = separator;
+        root->children[0] = tree->root;
+        root->children[1] = split;
+        tree->root = root;
+        tree->height++;
+    }
+}
+
+// Visit the keys in [low, high] in order through the leaf chain; returns the
+// number visited. The visitor may be NULL to only count.
+long bplusRange(const BPlusTree *tree, int low, int high, void (*visit)(int key, int value, void *context),
+                void *context)
+{
+    long visited = 0;
+    BPlusLeaf *leaf = findLeaf(tree, low);
+    for (int i = countLess(leaf->keys, leaf->count, low); leaf != NULL; leaf = leaf->next, i = 0)
+    {
+        for (; i < leaf->count; i++)
+        {
+            if (leaf->keys[i] > high)
+            {
+                return visited;
+            }
+            if (visit != NULL)
+            {
+                visit(leaf->keys[i], leaf->values[i], context);
+            }
+            visited++;
+        }
+    }
+    return visited;
+}
+
+// Build a B+tree from strictly increasing keys in one pass: leaves are
+// filled completely and chained, then each inner level is built over the
+// one below, spreading children evenly. Returns NULL if keys are unsorted.
+BPlusTree *bplusBulkLoad(const int *keys, const int *values, long count)
+{
+    for (long i = 1; i < count; i++)
+    {
+        if (keys[i - 1] >= keys[i])
+        {
+            printf("Bulk load needs strictly increasing keys.\n");
+            return NULL;
+        }
+    }
+    BPlusTree *tree = createBPlusTree();
+    if (count == 0)
+    {
+        return tree;
+    }
+    free(tree->root);
+    tree->nodes = 0;
+
+    long nodes = (count + BPLUS_LEAF_KEYS - 1) / BPLUS_LEAF_KEYS;
+    void **level = (void **)allocateNode(nodes * sizeof(void *));
+    int *lowest = (int *)allocateNode(nodes * sizeof(int));
+    BPlusLeaf *previous = NULL;
+    for (long n = 0; n < nodes; n++)
+    {
+        BPlusLeaf *leaf = (BPlusLeaf *)allocateBPlusNode(sizeof(BPlusLeaf));
+        long first = n * BPLUS_LEAF_KEYS;
+        leaf->count = (int)(count - first < BPLUS_LEAF_KEYS ? count - first : BPLUS_LEAF_KEYS);
+        memcpy(leaf->keys, keys + first, leaf->count * sizeof(int));
+        memcpy(leaf->values, values + first, leaf->count * sizeof(int));
+        if (previous != NULL)
+        {
+            previous->next = leaf;
+        }
+        previous = leaf;
+        level[n] = leaf;
+        lowest[n] = leaf->keys[0];
+    }
+    tree->nodes += nodes;
+
+    while (nodes > 1)
+    {
+        long parents = (nodes + BPLUS_INNER_KEYS) / (BPLUS_INNER_KEYS + 1);
+        long child = 0;
+        for (long p = 0; p < parents; p++)
+        {
+            BPlusInner *inner = (BPlusInner *)allocateBPlusNode(sizeof(BPlusInner));
+            long take = nodes / parents + (p < nodes % parents);
+            inner->count = (int)take - 1;
+            for (long i = 0; i < take; i++)
+            {
+                inner->children[i] = level[child + i];
+                if (i > 0)
+                {
+                    inner->keys[i - 1] = lowest[child + i];
+                }
+            }
+            lowest[p] = lowest[child];
+            level[p] = inner;
+            child += take;
+        }
+        tree->nodes += parents;
+        nodes = parents;
+        tree->height++;
+    }
+    tree->root = level[0];
+    tree->size = count;
+    free(level);
+    free(lowest);
+    return tree;
+}
+
+// Read-only snapshot of a search tree in Eytzinger (BFS) order: keys[1] is
+// the root and the children of keys[k] are keys[2k] and keys[2k + 1], so a
+// search needs no pointers and the top levels share a few cache lines
+typedef struct FrozenTree
+{
+    int *keys; // 1-based; keys[0] is unused
+    long size;
+} FrozenTree;
+
+// Keys of a tree in order; returns the number of keys
+long collectKeys(Node *root, int **keys)
+{
+    long size = 0, capacity = 64;
+    *keys = (int *)allocateNode(capacity * sizeof(int));
+    TreeIterator it;
+    initIterator(&it, root, TRAVERSE_INORDER);
+    for (Node *node = nextNode(&it); node != NULL; node = nextNode(&it))
+    {
+        if (size == capacity)
+        {
+            capacity *= 2;
+            int *grown = (int *)realloc(*keys, capacity * sizeof(int));
+            if (grown == NULL)
+            {
+                printf("Memory allocation failed.\n");
+                exit(1);
+            }
+            *keys = grown;
+        }
+        (*keys)[size++] = node->data;
+    }
+    freeIterator(&it);
+    return size;
+}
+
+// Lay sorted keys out in Eytzinger order by an in-order walk of the implicit
+// tree; returns the next sorted key to place
+long placeEytzinger(FrozenTree *frozen, const int *sorted, long next, long k)
+{
+    if (k <= frozen->size)
+    {
+        next = placeEytzinger(frozen, sorted, next, 2 * k);
+        frozen->keys[k] = sorted[next++];
+        next = placeEytzinger(frozen, sorted, next, 2 * k + 1);
+    }
+    return next;
+}
+
+// Freeze a search tree into an Eytzinger array; the tree is left untouched.
+// The array is cache-line aligned so the 16 descendants four levels below a
+// node share one line.
+FrozenTree *freezeTree(Node *root)
+{
+    int *sorted;
+    FrozenTree *frozen = (FrozenTree *)allocateNode(sizeof(FrozenTree));
+    frozen->size = collectKeys(root, &sorted);
+    void *memory;
+    if (posix_memalign(&memory, 64, (frozen->size + 1) * sizeof(int)) != 0)
+    {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    frozen->keys = (int *)memory;
+    frozen->keys[0] = 0;
+    placeEytzinger(frozen, sorted, 0, 1);
+    free(sorted);
+    return frozen;
+}
+
+void freeFrozenTree(FrozenTree *frozen)
+{
+    free(frozen->keys);
+    free(frozen);
+}
+
+// Descend the implicit tree going right whenever keys[k] is below the key
+// (or not above it, for upper bounds), then undo the final run of right
+// turns to land on the answer. The step is a conditional add rather than a
+// branch, and the line holding the node four levels down is prefetched
+// while the current comparison resolves. Returns 0 if every key is smaller.
+long eytzingerBound(const FrozenTree *frozen, int key, int upper)
+{
+    const int *keys = frozen->keys;
+    long k = 1;
+    while (k <= frozen->size)
+    {
+        __builtin_prefetch(keys + 16 * k);
+        k = 2 * k + (upper ? keys[k] <= key : keys[k] < key);
+    }
+    return k >> __builtin_ffsl(~k);
+}
+
+// Smallest key not below the given one; returns 0 if there is none
+int frozenLowerBound(const FrozenTree *frozen, int key, int *result)
+{
+    long k = eytzingerBound(frozen, key, 0);
+    if (k == 0)
+    {
+        return 0;
+    }
+    *result = frozen->keys[k];
+    return 1;
+}
+
+// Smallest key above the given one; returns 0 if there is none
+int frozenUpperBound(const FrozenTree *frozen, int key, int *result)
+{
+    long k = eytzingerBound(frozen, key, 1);
+    if (k == 0)
+    {
+        return 0;
+    }
+    *result = frozen->keys[k];
+    return 1;
+}
+
+// Search a frozen tree; returns 1 if the key is present
+int searchFrozen(const FrozenTree *frozen, int key)
+{
+    long k = eytzingerBound(frozen, key, 0);
+    return k != 0 && frozen->keys[k] == key;
+}
+
+// Traversal callback adding each value to a running sum
+void addValue(int value, void *context)
+{
+    *(long *)context += value;
 }
 
 // Main function to demonstrate tree operations
@@ -158,6 +1109,89 @@ int main()
     {
         printf("The tree is not balanced.\n");
     }
+    freeTree(root);
+
+    // Sorted input degenerates a plain BST into a list; AVL stays shallow
+    Node *plain = NULL;
+    Node *avl = NULL;
+    for (int i = 1; i <= 10000; i++)
+    {
+        plain = insertBST(plain, i);
+        avl = insertAVL(avl, i);
+    }
+    printf("Sorted inserts of 10000 keys: BST height %d, AVL height %d\n", height(plain), height(avl));
+
+    // Traversals of the degenerate tree need no recursion, and Morris
+    // traversal not even a stack
+    long sum = 0;
+    long visited = morrisInorder(plain, addValue, &sum);
+    int last[5];
+    long written = traverseToBuffer(plain, TRAVERSE_POSTORDER, last, 5);
+    printf("Morris inorder visited %ld keys summing to %ld; postorder starts", visited, sum);
+    for (long i = 0; i < written; i++)
+    {
+        printf(" %d", last[i]);
+    }
+    printf("\n");
+    freeTree(plain);
+
+    for (int i = 2; i <= 10000; i += 2)
+    {
+        avl = deleteAVL(avl, i);
+    }
+    printf("After deleting even keys: AVL height %d, %s, first keys:", height(avl),
+           isBalanced(avl) ? "balanced" : "not balanced");
+    Node *node = minNode(avl);
+    for (int i = 0; i < 5 && node != NULL; i++)
+    {
+        printf(" %d", node->data);
+        node = nextInOrder(avl, node->data);
+    }
+    printf("\n");
+    printf("Key 4 %s, key 5 %s\n", searchBST(avl, 4) != NULL ? "found" : "not found",
+           searchBST(avl, 5) != NULL ? "found" : "not found");
+
+    // Freeze the tree for read-only lookups
+    FrozenTree *frozen = freezeTree(avl);
+    int bound;
+    printf("Frozen %ld keys:", frozen->size);
+    if (frozenLowerBound(frozen, 4, &bound))
+    {
+        printf(" lower bound of 4 is %d,", bound);
+    }
+    if (frozenUpperBound(frozen, 5, &bound))
+    {
+        printf(" upper bound of 5 is %d,", bound);
+    }
+    printf(" key 9999 %s\n", searchFrozen(frozen, 9999) ? "found" : "not found");
+    freeFrozenTree(frozen);
+    freeTree(avl);
+    printPoolStats(&treeNodes, "Tree node");
+    poolRelease(&treeNodes);
+
+    // B+tree index: bulk load sorted keys, then point and range queries
+    long count = 1000000;
+    int *keys = (int *)allocateNode(count * sizeof(int));
+    int *values = (int *)allocateNode(count * sizeof(int));
+    for (long i = 0; i < count; i++)
+    {
+        keys[i] = (int)(i * 2);
+        values[i] = (int)i;
+    }
+    BPlusTree *index = bplusBulkLoad(keys, values, count);
+    int value;
+    printf("B+tree of %ld keys: %d inner levels, %.1f bytes per key (Node: %zu)\n", index->size, index->height,
+           (double)index->nodes * sizeof(BPlusLeaf) / index->size, sizeof(Node));
+    printf("Key 123456 %s", bplusSearch(index, 123456, &value) ? "found" : "not found");
+    printf(", key 123457 %s\n", bplusSearch(index, 123457, &value) ? "found" : "not found");
+    for (int key = 1; key < 200; key += 2)
+    {
+        bplusInsert(index, key, -key);
+    }
+    printf("Keys in [0, 299] after inserting odd keys below 200: %ld\n", bplusRange(index, 0, 299, NULL, NULL));
+    freeBPlusTree(index);
+    free(keys);
+    free(values);
 
     return 0;
 }
\ No newline at end of file